@@ -0,0 +1,147 @@
+//Standard includes
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+//Project includes
+#include "Math.h"
+
+using namespace dae;
+
+//Times the header-only, SIMD-backed math types against the out-of-line scalar code they replaced, which is kept below as
+//it was in Vector3.cpp and Matrix.cpp. Also checks that both give the same bits, renders depend on that
+namespace
+{
+#if defined(_MSC_VER)
+#define MATH_BENCHMARK_NOINLINE __declspec(noinline)
+#else
+#define MATH_BENCHMARK_NOINLINE __attribute__((noinline))
+#endif
+
+	constexpr size_t ValueCount{ 4096 };
+	constexpr int RunCount{ 15 };
+
+	namespace Scalar
+	{
+		MATH_BENCHMARK_NOINLINE Vector3 TransformPoint(const Matrix& m, const Vector3& p)
+		{
+			return Vector3{
+				m[0].x * p.x + m[1].x * p.y + m[2].x * p.z + m[3].x,
+				m[0].y * p.x + m[1].y * p.y + m[2].y * p.z + m[3].y,
+				m[0].z * p.x + m[1].z * p.y + m[2].z * p.z + m[3].z,
+			};
+		}
+
+		MATH_BENCHMARK_NOINLINE Vector3 TransformVector(const Matrix& m, const Vector3& v)
+		{
+			return Vector3{
+				m[0].x * v.x + m[1].x * v.y + m[2].x * v.z,
+				m[0].y * v.x + m[1].y * v.y + m[2].y * v.z,
+				m[0].z * v.x + m[1].z * v.y + m[2].z * v.z
+			};
+		}
+
+		MATH_BENCHMARK_NOINLINE Matrix Multiply(const Matrix& a, const Matrix& b)
+		{
+			Matrix result{};
+			const Matrix bTransposed{ Matrix::Transpose(b) };
+			for (int r{ 0 }; r < 4; ++r)
+			{
+				for (int c{ 0 }; c < 4; ++c)
+				{
+					result[r][c] = Vector4::Dot(a[r], bTransposed[c]);
+				}
+			}
+			return result;
+		}
+
+		MATH_BENCHMARK_NOINLINE Vector3 Normalized(const Vector3& v)
+		{
+			const float m{ std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z) };
+			return { v.x / m, v.y / m, v.z / m };
+		}
+	}
+
+	//Best time of RunCount passes over every value, in nanoseconds per value. The results are summed into sink so the
+	//compiler cannot drop the work
+	template<typename Operation>
+	double TimeOperation(const Operation& operation, float& sink)
+	{
+		double bestNs{ 1e30 };
+		for (int run{}; run < RunCount; ++run)
+		{
+			const auto start{ std::chrono::steady_clock::now() };
+			for (size_t i{}; i < ValueCount; ++i) sink += operation(i);
+			const double ns{ std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() };
+			bestNs = std::min(bestNs, ns / ValueCount);
+		}
+		return bestNs;
+	}
+
+	bool IsSame(const Vector3& a, const Vector3& b)
+	{
+		return std::memcmp(&a, &b, sizeof(Vector3)) == 0;
+	}
+
+	bool IsSame(const Matrix& a, const Matrix& b)
+	{
+		for (int r{}; r < 4; ++r)
+		{
+			const Vector4 aRow{ a[r] }, bRow{ b[r] };
+			if (std::memcmp(&aRow, &bRow, sizeof(Vector4)) != 0) return false;
+		}
+		return true;
+	}
+
+	void PrintResult(const char* pName, double scalarNs, double currentNs, bool isSame)
+	{
+		std::cout << pName << ": " << scalarNs << " -> " << currentNs << " ns/op" << (isSame ? "" : " (RESULTS DIFFER)") << '\n';
+	}
+}
+
+int main()
+{
+	//deterministic values, the same on every run
+	std::vector<Vector3> points(ValueCount);
+	std::vector<Matrix> matrices(ValueCount);
+	for (size_t i{}; i < ValueCount; ++i)
+	{
+		const float value{ float(i) };
+		points[i] = { std::sin(value) * 10.f, std::cos(value * .7f) * 10.f, std::sin(value * 1.3f) * 10.f + 11.f };
+		matrices[i] = Matrix::CreateScale(1.f + value * 1e-4f, 1.f, .5f) * Matrix::CreateRotation(value * .01f, value * .02f, value * .03f)
+			* Matrix::CreateTranslation(points[i]);
+	}
+	const Matrix& transform{ matrices[ValueCount / 2] };
+
+	bool isSame{ true };
+	float sink{};
+
+	for (size_t i{}; i < ValueCount; ++i) isSame &= IsSame(Scalar::TransformPoint(transform, points[i]), transform.TransformPoint(points[i]));
+	PrintResult("TransformPoint",
+		TimeOperation([&](size_t i) { return Scalar::TransformPoint(transform, points[i]).x; }, sink),
+		TimeOperation([&](size_t i) { return transform.TransformPoint(points[i]).x; }, sink), isSame);
+
+	isSame = true;
+	for (size_t i{}; i < ValueCount; ++i) isSame &= IsSame(Scalar::TransformVector(transform, points[i]), transform.TransformVector(points[i]));
+	PrintResult("TransformVector",
+		TimeOperation([&](size_t i) { return Scalar::TransformVector(transform, points[i]).x; }, sink),
+		TimeOperation([&](size_t i) { return transform.TransformVector(points[i]).x; }, sink), isSame);
+
+	isSame = true;
+	for (size_t i{}; i < ValueCount; ++i) isSame &= IsSame(Scalar::Multiply(transform, matrices[i]), transform * matrices[i]);
+	PrintResult("Matrix * Matrix",
+		TimeOperation([&](size_t i) { return Scalar::Multiply(transform, matrices[i])[3].x; }, sink),
+		TimeOperation([&](size_t i) { return (transform * matrices[i])[3].x; }, sink), isSame);
+
+	isSame = true;
+	for (size_t i{}; i < ValueCount; ++i) isSame &= IsSame(Scalar::Normalized(points[i]), points[i].Normalized());
+	PrintResult("Normalized",
+		TimeOperation([&](size_t i) { return Scalar::Normalized(points[i]).x; }, sink),
+		TimeOperation([&](size_t i) { return points[i].Normalized().x; }, sink), isSame);
+
+	std::cout << "(" << ValueCount << " values, best of " << RunCount << " runs, checksum " << sink << ")" << std::endl;
+	return 0;
+}
@@ -0,0 +1,285 @@
+#include "BVH.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace dae
+{
+	namespace
+	{
+		constexpr int BIN_COUNT{ 8 };
+
+		struct Bin
+		{
+			Vector3 minAABB{ FLT_MAX, FLT_MAX, FLT_MAX };
+			Vector3 maxAABB{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+			uint32_t primitiveCount{};
+		};
+
+		float SurfaceArea(const Vector3& minAABB, const Vector3& maxAABB)
+		{
+			const Vector3 extent{ maxAABB - minAABB };
+			return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+		}
+
+		void GrowAABB(Vector3& minAABB, Vector3& maxAABB, const Vector3& point)
+		{
+			minAABB = Vector3::Min(minAABB, point);
+			maxAABB = Vector3::Max(maxAABB, point);
+		}
+	}
+
+	void BVH::Build(const std::vector<Vector3>& positions, const std::vector<int>& indices)
+	{
+		const auto start{ std::chrono::high_resolution_clock::now() };
+
+		UpdateTriangleBounds(positions, indices);
+		BuildFromPrimitiveBounds();
+
+		const auto end{ std::chrono::high_resolution_clock::now() };
+		m_BuildTime = std::chrono::duration<float, std::milli>(end - start).count();
+	}
+
+	void BVH::Build(const std::vector<Vector3>& minAABBs, const std::vector<Vector3>& maxAABBs)
+	{
+		const auto start{ std::chrono::high_resolution_clock::now() };
+
+		m_PrimitiveMinAABBs = minAABBs;
+		m_PrimitiveMaxAABBs = maxAABBs;
+
+		BuildFromPrimitiveBounds();
+
+		const auto end{ std::chrono::high_resolution_clock::now() };
+		m_BuildTime = std::chrono::duration<float, std::milli>(end - start).count();
+	}
+
+	void BVH::Refit(const std::vector<Vector3>& positions, const std::vector<int>& indices)
+	{
+		const auto start{ std::chrono::high_resolution_clock::now() };
+
+		UpdateTriangleBounds(positions, indices);
+
+		//children are always allocated after their parent, so walking backwards visits them first
+		for (int nodeIndex{ static_cast<int>(m_Nodes.size()) - 1 }; nodeIndex >= 0; --nodeIndex)
+		{
+			BVHNode& node{ m_Nodes[nodeIndex] };
+			if (node.IsLeaf())
+			{
+				UpdateNodeBounds(node);
+				continue;
+			}
+
+			const BVHNode& leftChild{ m_Nodes[node.leftFirst] };
+			const BVHNode& rightChild{ m_Nodes[node.leftFirst + 1] };
+			node.minAABB = Vector3::Min(leftChild.minAABB, rightChild.minAABB);
+			node.maxAABB = Vector3::Max(leftChild.maxAABB, rightChild.maxAABB);
+		}
+
+		m_Cost = CalculateSAHCost();
+
+		const auto end{ std::chrono::high_resolution_clock::now() };
+		m_RefitTime = std::chrono::duration<float, std::milli>(end - start).count();
+	}
+
+	void BVH::UpdateTriangleBounds(const std::vector<Vector3>& positions, const std::vector<int>& indices)
+	{
+		const size_t triangleCount{ indices.size() / 3 };
+		m_PrimitiveMinAABBs.resize(triangleCount);
+		m_PrimitiveMaxAABBs.resize(triangleCount);
+
+		for (size_t i{}; i < triangleCount; ++i)
+		{
+			const Vector3& v0{ positions[indices[i * 3]] };
+			const Vector3& v1{ positions[indices[i * 3 + 1]] };
+			const Vector3& v2{ positions[indices[i * 3 + 2]] };
+
+			m_PrimitiveMinAABBs[i] = Vector3::Min(v0, Vector3::Min(v1, v2));
+			m_PrimitiveMaxAABBs[i] = Vector3::Max(v0, Vector3::Max(v1, v2));
+		}
+	}
+
+	float BVH::CalculateSAHCost() const
+	{
+		//expected cost of a random ray hitting the root: traversal steps + triangle tests, weighted by the chance to enter each node
+		if (m_Nodes.empty()) return 0.f;
+
+		const float rootArea{ SurfaceArea(m_Nodes[0].minAABB, m_Nodes[0].maxAABB) };
+		if (rootArea <= 0.f) return 0.f;
+
+		float cost{};
+		for (const BVHNode& node : m_Nodes)
+		{
+			const float area{ SurfaceArea(node.minAABB, node.maxAABB) };
+			cost += area * (node.IsLeaf() ? static_cast<float>(node.primitiveCount) : 1.f);
+		}
+		return cost / rootArea;
+	}
+
+	void BVH::BuildFromPrimitiveBounds()
+	{
+		const uint32_t primitiveCount{ static_cast<uint32_t>(m_PrimitiveMinAABBs.size()) };
+
+		m_Nodes.clear();
+		m_PrimitiveIndices.resize(primitiveCount);
+		m_Centroids.resize(primitiveCount);
+		m_NodesUsed = 0;
+		m_BuildCost = 0.f;
+		m_Cost = 0.f;
+
+		if (primitiveCount == 0) return;
+
+		for (uint32_t i{}; i < primitiveCount; ++i)
+		{
+			m_PrimitiveIndices[i] = i;
+			m_Centroids[i] = (m_PrimitiveMinAABBs[i] + m_PrimitiveMaxAABBs[i]) * 0.5f;
+		}
+
+		//a binary tree with N leaves never needs more than 2N - 1 nodes
+		m_Nodes.resize(primitiveCount * 2 - 1);
+
+		BVHNode& root{ m_Nodes[m_NodesUsed++] };
+		root.leftFirst = 0;
+		root.primitiveCount = primitiveCount;
+		UpdateNodeBounds(root);
+
+		Subdivide(0, 1);
+
+		m_Nodes.resize(m_NodesUsed);
+
+		m_BuildCost = CalculateSAHCost();
+		m_Cost = m_BuildCost;
+	}
+
+	void BVH::UpdateNodeBounds(BVHNode& node) const
+	{
+		node.minAABB = { FLT_MAX, FLT_MAX, FLT_MAX };
+		node.maxAABB = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+		for (uint32_t i{}; i < node.primitiveCount; ++i)
+		{
+			const uint32_t primitiveIndex{ m_PrimitiveIndices[node.leftFirst + i] };
+			node.minAABB = Vector3::Min(node.minAABB, m_PrimitiveMinAABBs[primitiveIndex]);
+			node.maxAABB = Vector3::Max(node.maxAABB, m_PrimitiveMaxAABBs[primitiveIndex]);
+		}
+	}
+
+	void BVH::Subdivide(uint32_t nodeIndex, uint32_t depth)
+	{
+		BVHNode& node{ m_Nodes[nodeIndex] };
+		if (node.primitiveCount <= 1 || depth >= MaxDepth) return;
+
+		int axis{};
+		float splitPosition{};
+		const float splitCost{ FindBestSplitPlane(node, axis, splitPosition) };
+		const float noSplitCost{ node.primitiveCount * SurfaceArea(node.minAABB, node.maxAABB) };
+		if (splitCost >= noSplitCost) return;
+
+		//in-place partition of the primitive indices around the split plane
+		int i{ static_cast<int>(node.leftFirst) };
+		int j{ i + static_cast<int>(node.primitiveCount) - 1 };
+		while (i <= j)
+		{
+			if (m_Centroids[m_PrimitiveIndices[i]][axis] < splitPosition)
+				++i;
+			else
+				std::swap(m_PrimitiveIndices[i], m_PrimitiveIndices[j--]);
+		}
+
+		const uint32_t leftCount{ i - node.leftFirst };
+		if (leftCount == 0 || leftCount == node.primitiveCount) return;
+
+		const uint32_t leftChildIndex{ m_NodesUsed++ };
+		const uint32_t rightChildIndex{ m_NodesUsed++ };
+
+		BVHNode& leftChild{ m_Nodes[leftChildIndex] };
+		leftChild.leftFirst = node.leftFirst;
+		leftChild.primitiveCount = leftCount;
+		UpdateNodeBounds(leftChild);
+
+		BVHNode& rightChild{ m_Nodes[rightChildIndex] };
+		rightChild.leftFirst = i;
+		rightChild.primitiveCount = node.primitiveCount - leftCount;
+		UpdateNodeBounds(rightChild);
+
+		node.leftFirst = leftChildIndex;
+		node.primitiveCount = 0;
+
+		Subdivide(leftChildIndex, depth + 1);
+		Subdivide(rightChildIndex, depth + 1);
+	}
+
+	float BVH::FindBestSplitPlane(const BVHNode& node, int& axis, float& splitPosition) const
+	{
+		float bestCost{ FLT_MAX };
+
+		for (int a{}; a < 3; ++a)
+		{
+			//bin along the centroid bounds, the primitive bounds can be much wider than where the centroids live
+			float boundsMin{ FLT_MAX };
+			float boundsMax{ -FLT_MAX };
+			for (uint32_t i{}; i < node.primitiveCount; ++i)
+			{
+				const float centroid{ m_Centroids[m_PrimitiveIndices[node.leftFirst + i]][a] };
+				boundsMin = std::min(boundsMin, centroid);
+				boundsMax = std::max(boundsMax, centroid);
+			}
+			if (boundsMin == boundsMax) continue;
+
+			Bin bins[BIN_COUNT]{};
+			const float scale{ BIN_COUNT / (boundsMax - boundsMin) };
+			for (uint32_t i{}; i < node.primitiveCount; ++i)
+			{
+				const uint32_t primitiveIndex{ m_PrimitiveIndices[node.leftFirst + i] };
+				const int binIndex{ std::min(BIN_COUNT - 1, static_cast<int>((m_Centroids[primitiveIndex][a] - boundsMin) * scale)) };
+
+				Bin& bin{ bins[binIndex] };
+				++bin.primitiveCount;
+				bin.minAABB = Vector3::Min(bin.minAABB, m_PrimitiveMinAABBs[primitiveIndex]);
+				bin.maxAABB = Vector3::Max(bin.maxAABB, m_PrimitiveMaxAABBs[primitiveIndex]);
+			}
+
+			//sweep from both sides to get the area and count left and right of every bin boundary
+			float leftArea[BIN_COUNT - 1]{}, rightArea[BIN_COUNT - 1]{};
+			uint32_t leftCount[BIN_COUNT - 1]{}, rightCount[BIN_COUNT - 1]{};
+
+			Vector3 leftMin{ FLT_MAX, FLT_MAX, FLT_MAX }, leftMax{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+			Vector3 rightMin{ FLT_MAX, FLT_MAX, FLT_MAX }, rightMax{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+			uint32_t leftSum{}, rightSum{};
+			for (int i{}; i < BIN_COUNT - 1; ++i)
+			{
+				leftSum += bins[i].primitiveCount;
+				leftCount[i] = leftSum;
+				if (bins[i].primitiveCount > 0)
+				{
+					GrowAABB(leftMin, leftMax, bins[i].minAABB);
+					GrowAABB(leftMin, leftMax, bins[i].maxAABB);
+				}
+				leftArea[i] = leftSum > 0 ? SurfaceArea(leftMin, leftMax) : 0.f;
+
+				const int r{ BIN_COUNT - 1 - i };
+				rightSum += bins[r].primitiveCount;
+				rightCount[r - 1] = rightSum;
+				if (bins[r].primitiveCount > 0)
+				{
+					GrowAABB(rightMin, rightMax, bins[r].minAABB);
+					GrowAABB(rightMin, rightMax, bins[r].maxAABB);
+				}
+				rightArea[r - 1] = rightSum > 0 ? SurfaceArea(rightMin, rightMax) : 0.f;
+			}
+
+			const float binWidth{ (boundsMax - boundsMin) / BIN_COUNT };
+			for (int i{}; i < BIN_COUNT - 1; ++i)
+			{
+				const float cost{ leftCount[i] * leftArea[i] + rightCount[i] * rightArea[i] };
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					axis = a;
+					splitPosition = boundsMin + binWidth * (i + 1);
+				}
+			}
+		}
+
+		return bestCost;
+	}
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "Math.h"
+
+namespace dae
+{
+	struct BVHNode
+	{
+		Vector3 minAABB{};
+		uint32_t leftFirst{}; //interior: index of left child (right = left + 1), leaf: first entry in primitive indices
+		Vector3 maxAABB{};
+		uint32_t primitiveCount{}; //0 for interior nodes
+
+		bool IsLeaf() const { return primitiveCount > 0; }
+	};
+
+	//Bounding Volume Hierarchy built with the (binned) Surface Area Heuristic.
+	//Used both as bottom level (triangles of one mesh) and top level (mesh instances) structure
+	class BVH final
+	{
+	public:
+		BVH() = default;
+		~BVH() = default;
+
+		static constexpr uint32_t MaxDepth{ 64 };
+		//Refitted trees whose SAH cost grew beyond this factor of the freshly built cost should be rebuilt
+		static constexpr float RebuildThreshold{ 1.5f };
+
+		/**
+		 * \brief Builds the hierarchy over the triangles of a mesh
+		 * \param positions vertex positions the tree is built in (the space rays will be tested in)
+		 * \param indices triangle list, 3 indices per triangle
+		 */
+		void Build(const std::vector<Vector3>& positions, const std::vector<int>& indices);
+
+		/**
+		 * \brief Builds the hierarchy over arbitrary primitives given by their bounding boxes
+		 * \param minAABBs minimum corner per primitive
+		 * \param maxAABBs maximum corner per primitive
+		 */
+		void Build(const std::vector<Vector3>& minAABBs, const std::vector<Vector3>& maxAABBs);
+
+		/**
+		 * \brief Recomputes all node bounds bottom-up for moved vertices, the topology of the tree is kept
+		 * \param positions moved vertex positions, same count and order as used in Build
+		 * \param indices same triangle list as used in Build
+		 */
+		void Refit(const std::vector<Vector3>& positions, const std::vector<int>& indices);
+
+		const std::vector<BVHNode>& GetNodes() const { return m_Nodes; }
+		//Primitive numbers (triangle: index into indices / 3) in leaf order
+		const std::vector<uint32_t>& GetPrimitiveIndices() const { return m_PrimitiveIndices; }
+
+		uint32_t GetNodeCount() const { return static_cast<uint32_t>(m_Nodes.size()); }
+		uint32_t GetPrimitiveCount() const { return static_cast<uint32_t>(m_PrimitiveIndices.size()); }
+		float GetBuildTime() const { return m_BuildTime; } //ms
+		float GetRefitTime() const { return m_RefitTime; } //ms
+
+		//SAH cost of the current tree relative to its cost right after the last build, 1 for a fresh tree
+		float GetQualityRatio() const { return m_BuildCost > 0.f ? m_Cost / m_BuildCost : 1.f; }
+		bool NeedsRebuild() const { return GetQualityRatio() > RebuildThreshold; }
+
+	private:
+		void BuildFromPrimitiveBounds();
+		void UpdateTriangleBounds(const std::vector<Vector3>& positions, const std::vector<int>& indices);
+		float CalculateSAHCost() const;
+		void UpdateNodeBounds(BVHNode& node) const;
+		void Subdivide(uint32_t nodeIndex, uint32_t depth);
+		float FindBestSplitPlane(const BVHNode& node, int& axis, float& splitPosition) const;
+
+		std::vector<BVHNode> m_Nodes{};
+		std::vector<uint32_t> m_PrimitiveIndices{};
+
+		//one entry per primitive, the bounds are kept around for refitting
+		std::vector<Vector3> m_PrimitiveMinAABBs{};
+		std::vector<Vector3> m_PrimitiveMaxAABBs{};
+		std::vector<Vector3> m_Centroids{};
+
+		uint32_t m_NodesUsed{};
+		float m_BuildTime{};
+		float m_RefitTime{};
+
+		float m_BuildCost{};
+		float m_Cost{};
+	};
+}
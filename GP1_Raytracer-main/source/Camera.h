@@ -1,15 +1,31 @@
 #pragma once
 #include <cassert>
-#include <SDL_keyboard.h>
-#include <SDL_mouse.h>
 
 #include "Math.h"
-#include "Timer.h"
 
 #include <iostream>
 
 namespace dae
 {
+	//What the camera reacts to in a frame, read from the window's keyboard and mouse by the caller
+	struct CameraInput
+	{
+		bool isMovingForward{ false };	//W
+		bool isMovingBackward{ false };	//S
+		bool isMovingLeft{ false };		//A
+		bool isMovingRight{ false };	//D
+		bool isMovingUp{ false };		//Q
+		bool isMovingDown{ false };		//E
+		bool isWideningFov{ false };	//down arrow
+		bool isNarrowingFov{ false };	//up arrow
+
+		//relative mouse motion since the last frame
+		int mouseX{};
+		int mouseY{};
+		bool isLeftButtonDown{ false };
+		bool isRightButtonDown{ false };
+	};
+
 	struct Camera
 	{
 		Camera() = default;
@@ -50,36 +66,31 @@ namespace dae
 			};
 		}
 
-		void Update(Timer* pTimer)
+		void Update(float deltaTime, const CameraInput& input)
 		{
-			const float deltaTime = pTimer->GetElapsed();
-
-			//Keyboard Input
-			const uint8_t* pKeyboardState = SDL_GetKeyboardState(nullptr);
-
 			// movement
 			const float SPEED{7};
-			if (pKeyboardState[SDL_SCANCODE_W])
+			if (input.isMovingForward)
 			{
 				origin += forward *  SPEED * deltaTime;
 			}
-			if (pKeyboardState[SDL_SCANCODE_S])
+			if (input.isMovingBackward)
 			{
 				origin -= forward * SPEED * deltaTime;
 			}
-			if (pKeyboardState[SDL_SCANCODE_A])
+			if (input.isMovingLeft)
 			{
 				origin -= right * SPEED * deltaTime;
 			}
-			if (pKeyboardState[SDL_SCANCODE_D])
+			if (input.isMovingRight)
 			{
 				origin += right * SPEED * deltaTime;
 			}
-			if (pKeyboardState[SDL_SCANCODE_Q])
+			if (input.isMovingUp)
 			{
 				origin.y += up.y * SPEED * deltaTime;
 			}
-			if (pKeyboardState[SDL_SCANCODE_E])
+			if (input.isMovingDown)
 			{
 				origin.y -= up.y * SPEED * deltaTime;
 			}
@@ -89,12 +100,12 @@ namespace dae
 			const int MAX_FOV			{ 160 };
 			const int MIN_FOV			{ 10 };
 
-			if (pKeyboardState[SDL_SCANCODE_DOWN] && fovAngle < MAX_FOV)
+			if (input.isWideningFov && fovAngle < MAX_FOV)
 			{
 				fovAngle += FOV_INCREMENT * deltaTime;
 				fovValue = tanf(fovAngle * TO_RADIANS / 2.f);
 			}
-			if (pKeyboardState[SDL_SCANCODE_UP] && fovAngle > MIN_FOV)
+			if (input.isNarrowingFov && fovAngle > MIN_FOV)
 			{
 				fovAngle -= FOV_INCREMENT * deltaTime;
 				fovValue = tanf(fovAngle * TO_RADIANS / 2.f);
@@ -112,17 +123,16 @@ namespace dae
 			}
 
 			//Mouse Input
-			int mouseX{}, mouseY{};
-			const uint32_t mouseState = SDL_GetRelativeMouseState(&mouseX, &mouseY);
+			const int mouseX{ input.mouseX }, mouseY{ input.mouseY };
 			const float SENSITIVITY{ 0.007f };
 			const float MOVEMENT_SENSITIVITY{ 0.07f };
 
-			if (mouseState & SDL_BUTTON_LMASK && mouseState & SDL_BUTTON_RMASK)
+			if (input.isLeftButtonDown && input.isRightButtonDown)
 			{
 				float movement = mouseY * MOVEMENT_SENSITIVITY;
 				origin.y -= up.y * movement;
 			}
-			else if (mouseState & SDL_BUTTON_RMASK)
+			else if (input.isRightButtonDown)
 			{
 				totalPitch += mouseX * SENSITIVITY;
 				totalYaw -= mouseY * SENSITIVITY;
@@ -131,7 +141,7 @@ namespace dae
 				forward = final.TransformVector(Vector3::UnitZ);
 				forward.Normalize();
 			}
-			else if (mouseState & SDL_BUTTON_LMASK)
+			else if (input.isLeftButtonDown)
 			{
 				totalPitch += mouseX * SENSITIVITY;
 				float movement = mouseY * MOVEMENT_SENSITIVITY;
@@ -9,7 +9,7 @@ namespace dae
 		float g{};
 		float b{};
 
-		void MaxToOne()
+		constexpr void MaxToOne()
 		{
 			const float maxValue = std::max(r, std::max(g, b));
 			if (maxValue > 1.f)
@@ -22,7 +22,7 @@ namespace dae
 		}
 
 		#pragma region ColorRGB (Member) Operators
-		const ColorRGB& operator+=(const ColorRGB& c)
+		constexpr const ColorRGB& operator+=(const ColorRGB& c)
 		{
 			r += c.r;
 			g += c.g;
@@ -31,17 +31,17 @@ namespace dae
 			return *this;
 		}
 
-		const ColorRGB& operator+(const ColorRGB& c)
+		constexpr const ColorRGB& operator+(const ColorRGB& c)
 		{
 			return *this += c;
 		}
 
-		ColorRGB operator+(const ColorRGB& c) const
+		constexpr ColorRGB operator+(const ColorRGB& c) const
 		{
 			return { r + c.r, g + c.g, b + c.b };
 		}
 
-		const ColorRGB& operator-=(const ColorRGB& c)
+		constexpr const ColorRGB& operator-=(const ColorRGB& c)
 		{
 			r -= c.r;
 			g -= c.g;
@@ -50,17 +50,17 @@ namespace dae
 			return *this;
 		}
 
-		const ColorRGB& operator-(const ColorRGB& c)
+		constexpr const ColorRGB& operator-(const ColorRGB& c)
 		{
 			return *this -= c;
 		}
 
-		ColorRGB operator-(const ColorRGB& c) const
+		constexpr ColorRGB operator-(const ColorRGB& c) const
 		{
 			return { r - c.r, g - c.g, b - c.b };
 		}
 
-		const ColorRGB& operator*=(const ColorRGB& c)
+		constexpr const ColorRGB& operator*=(const ColorRGB& c)
 		{
 			r *= c.r;
 			g *= c.g;
@@ -69,17 +69,17 @@ namespace dae
 			return *this;
 		}
 
-		const ColorRGB& operator*(const ColorRGB& c)
+		constexpr const ColorRGB& operator*(const ColorRGB& c)
 		{
 			return *this *= c;
 		}
 
-		ColorRGB operator*(const ColorRGB& c) const
+		constexpr ColorRGB operator*(const ColorRGB& c) const
 		{
 			return { r * c.r, g * c.g, b * c.b };
 		}
 
-		const ColorRGB& operator/=(const ColorRGB& c)
+		constexpr const ColorRGB& operator/=(const ColorRGB& c)
 		{
 			r /= c.r;
 			g /= c.g;
@@ -88,12 +88,12 @@ namespace dae
 			return *this;
 		}
 
-		const ColorRGB& operator/(const ColorRGB& c)
+		constexpr const ColorRGB& operator/(const ColorRGB& c)
 		{
 			return *this /= c;
 		}
 
-		const ColorRGB& operator*=(float s)
+		constexpr const ColorRGB& operator*=(float s)
 		{
 			r *= s;
 			g *= s;
@@ -102,17 +102,17 @@ namespace dae
 			return *this;
 		}
 
-		const ColorRGB& operator*(float s)
+		constexpr const ColorRGB& operator*(float s)
 		{
 			return *this *= s;
 		}
 
-		ColorRGB operator*(float s) const
+		constexpr ColorRGB operator*(float s) const
 		{
 			return { r * s, g * s,b * s };
 		}
 
-		const ColorRGB& operator/=(float s)
+		constexpr const ColorRGB& operator/=(float s)
 		{
 			r /= s;
 			g /= s;
@@ -121,7 +121,7 @@ namespace dae
 			return *this;
 		}
 
-		const ColorRGB& operator/(float s)
+		constexpr const ColorRGB& operator/(float s)
 		{
 			return *this /= s;
 		}
@@ -129,21 +129,21 @@ namespace dae
 	};
 
 	//ColorRGB (Global) Operators
-	inline ColorRGB operator*(float s, const ColorRGB& c)
+	constexpr ColorRGB operator*(float s, const ColorRGB& c)
 	{
 		return c * s;
 	}
 
 	namespace colors
 	{
-		static ColorRGB Red{ 1,0,0 };
-		static ColorRGB Blue{ 0,0,1 };
-		static ColorRGB Green{ 0,1,0 };
-		static ColorRGB Yellow{ 1,1,0 };
-		static ColorRGB Cyan{ 0,1,1 };
-		static ColorRGB Magenta{ 1,0,1 };
-		static ColorRGB White{ 1,1,1 };
-		static ColorRGB Black{ 0,0,0 };
-		static ColorRGB Gray{ 0.5f,0.5f,0.5f };
+		inline constexpr ColorRGB Red{ 1,0,0 };
+		inline constexpr ColorRGB Blue{ 0,0,1 };
+		inline constexpr ColorRGB Green{ 0,1,0 };
+		inline constexpr ColorRGB Yellow{ 1,1,0 };
+		inline constexpr ColorRGB Cyan{ 0,1,1 };
+		inline constexpr ColorRGB Magenta{ 1,0,1 };
+		inline constexpr ColorRGB White{ 1,1,1 };
+		inline constexpr ColorRGB Black{ 0,0,0 };
+		inline constexpr ColorRGB Gray{ 0.5f,0.5f,0.5f };
 	}
 }
\ No newline at end of file
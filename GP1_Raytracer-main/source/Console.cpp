@@ -0,0 +1,36 @@
+#include "Console.h"
+
+#include <iostream>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#endif
+
+namespace dae
+{
+	void SetConsoleColor(ConsoleColor color)
+	{
+#if defined(_WIN32)
+		SetConsoleTextAttribute(GetStdHandle(STD_OUTPUT_HANDLE), static_cast<WORD>(color));
+#else
+		switch (color)
+		{
+		case ConsoleColor::DarkRed:
+			std::cout << "\033[31m";
+			break;
+		case ConsoleColor::Green:
+			std::cout << "\033[92m";
+			break;
+		case ConsoleColor::Red:
+			std::cout << "\033[91m";
+			break;
+		case ConsoleColor::Yellow:
+			std::cout << "\033[93m";
+			break;
+		default:
+			std::cout << "\033[0m";
+			break;
+		}
+#endif
+	}
+}
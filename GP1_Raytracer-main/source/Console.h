@@ -0,0 +1,18 @@
+#pragma once
+#include <cstdint>
+
+namespace dae
+{
+	//Values are the Windows console text attributes, other platforms map them to ANSI escape codes
+	enum class ConsoleColor : uint16_t
+	{
+		Default = 0x07,
+		DarkRed = 0x04,
+		Green = 0x0a,
+		Red = 0x0c,
+		Yellow = 0x0e
+	};
+
+	//Colors everything written to std::cout from here on, reset with ConsoleColor::Default
+	void SetConsoleColor(ConsoleColor color);
+}
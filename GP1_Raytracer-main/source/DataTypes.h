@@ -2,6 +2,7 @@
 #include <cassert>
 
 #include "Math.h"
+#include "BVH.h"
 #include "vector"
 
 namespace dae
@@ -54,6 +55,50 @@ namespace dae
 		unsigned char materialIndex{};
 	};
 
+	//Triangles of a mesh packed in BVH leaf order as structure of arrays, so the intersection kernels stream through them
+	//linearly instead of gathering three vertices through the index buffer. Stores the precomputed Moller-Trumbore edges.
+	//The material is the mesh's, not stored per triangle
+	struct TriangleSoA
+	{
+		std::vector<float> v0x{}, v0y{}, v0z{};
+		std::vector<float> edge1x{}, edge1y{}, edge1z{};
+		std::vector<float> edge2x{}, edge2y{}, edge2z{};
+
+		//zeroed entries after the last triangle, so 8-wide kernels can load a full batch at the end of any leaf
+		static constexpr size_t Padding{ 7 };
+
+		size_t Size() const { return v0x.empty() ? 0 : v0x.size() - Padding; }
+
+		Vector3 GetV0(size_t i) const { return { v0x[i], v0y[i], v0z[i] }; }
+		Vector3 GetEdge1(size_t i) const { return { edge1x[i], edge1y[i], edge1z[i] }; }
+		Vector3 GetEdge2(size_t i) const { return { edge2x[i], edge2y[i], edge2z[i] }; }
+
+		void Build(const std::vector<Vector3>& positions, const std::vector<int>& indices, const std::vector<uint32_t>& order)
+		{
+			const size_t triangleCount{ order.size() };
+			for (std::vector<float>* pArray : { &v0x, &v0y, &v0z, &edge1x, &edge1y, &edge1z, &edge2x, &edge2y, &edge2z })
+				pArray->assign(triangleCount + Padding, 0.f);
+
+			for (size_t i{}; i < triangleCount; ++i)
+			{
+				const size_t firstIndex{ order[i] * size_t(3) };
+				const Vector3& v0{ positions[indices[firstIndex]] };
+				const Vector3 edge1{ positions[indices[firstIndex + 1]] - v0 };
+				const Vector3 edge2{ positions[indices[firstIndex + 2]] - v0 };
+
+				v0x[i] = v0.x;
+				v0y[i] = v0.y;
+				v0z[i] = v0.z;
+				edge1x[i] = edge1.x;
+				edge1y[i] = edge1.y;
+				edge1z[i] = edge1.z;
+				edge2x[i] = edge2.x;
+				edge2y[i] = edge2.y;
+				edge2z[i] = edge2.z;
+			}
+		}
+	};
+
 	struct TriangleMesh
 	{
 		TriangleMesh() = default;
@@ -90,8 +135,19 @@ namespace dae
 		Vector3 transformedMinAABB{};
 		Vector3 transformedMaxAABB{};
 
-		std::vector<Vector3> transformedPositions{};
-		std::vector<Vector3> transformedNormals{};
+		//Instance transform, rays are brought into object space so the BVH only has to be built once
+		Matrix worldTransform{};
+		Matrix inverseWorldTransform{};
+		Matrix normalTransform{};
+		bool flipsWinding{ false };
+
+		//Bottom level BVH in object space, rebuilt when the indices change and refitted when only the positions moved
+		BVH bvh{};
+		TriangleSoA triangleData{};
+		bool isGeometryDirty{ true };
+		bool arePositionsDirty{ false };
+		bool isTriangleDataDirty{ true };
+		bool hasShapeChanged{ true }; //object space positions changed, cleared once the scene picked it up
 
 		void Translate(const Vector3& translation)
 		{
@@ -142,6 +198,7 @@ namespace dae
 
 			normals.push_back(triangle.normal);
 
+			isGeometryDirty = true;
 			if(!ignoreTransformUpdate) UpdateTransforms();
 		}
 
@@ -165,27 +222,41 @@ namespace dae
 
 		void UpdateTransforms()
 		{
-			Matrix finalTransform = rotationTransform * scaleTransform * translationTransform;
-
-			transformedPositions.clear();
-			transformedNormals.clear();
-
-			transformedPositions.reserve(positions.size());
-			transformedNormals.reserve(normals.size());
-
-			for (int i{}; i < positions.size(); ++i)
+			if (isGeometryDirty)
+			{
+				UpdateAABB();
+				bvh.Build(positions, indices);
+				isGeometryDirty = false;
+				arePositionsDirty = false;
+				isTriangleDataDirty = true;
+				hasShapeChanged = true;
+			}
+			else if (arePositionsDirty)
 			{
-				Vector3 transformedPosition = finalTransform.TransformPoint(positions[i]);
-				transformedPositions.emplace_back(transformedPosition);
+				//deforming mesh: refitting is O(n) with a small constant, rebuild only once the tree degraded too far
+				UpdateAABB();
+				bvh.Refit(positions, indices);
+				if (bvh.NeedsRebuild()) bvh.Build(positions, indices);
+				arePositionsDirty = false;
+				isTriangleDataDirty = true;
+				hasShapeChanged = true;
 			}
 
-			for (int i{}; i < normals.size(); ++i)
+			if (isTriangleDataDirty)
 			{
-				Vector3 transformedNormal = rotationTransform.TransformVector(normals[i]);
-				transformedNormals.emplace_back(transformedNormal);
+				triangleData.Build(positions, indices, bvh.GetPrimitiveIndices());
+				isTriangleDataDirty = false;
 			}
 
-			UpdateTransformedAABB(finalTransform);
+			worldTransform = rotationTransform * scaleTransform * translationTransform;
+			inverseWorldTransform = Matrix::Inverse(worldTransform);
+			normalTransform = Matrix::Transpose(inverseWorldTransform);
+
+			//a mirroring transform swaps front and back faces in object space
+			const float determinant{ Vector3::Dot(worldTransform.GetAxisX(), Vector3::Cross(worldTransform.GetAxisY(), worldTransform.GetAxisZ())) };
+			flipsWinding = determinant < 0.f;
+
+			UpdateTransformedAABB(worldTransform);
 		}
 
 		void UpdateAABB()
@@ -277,5 +348,22 @@ namespace dae
 		bool didHit{ false };
 		unsigned char materialIndex{ 0 };
 	};
+
+	//Primitive that blocked the last shadow ray towards a light, neighbouring pixels usually get blocked by the same one
+	struct Occluder
+	{
+		enum class Type : unsigned char
+		{
+			None,
+			Sphere,
+			Plane,
+			Triangle,
+			TriangleMesh
+		};
+
+		Type type{ Type::None };
+		uint32_t index{}; //into the scene's geometry of that type
+		uint32_t triangle{}; //packed triangle for TriangleMesh
+	};
 #pragma endregion
 }
\ No newline at end of file
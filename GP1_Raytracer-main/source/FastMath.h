@@ -0,0 +1,100 @@
+#pragma once
+#include <bit>
+#include <cmath>
+#include <cstdint>
+
+#include "Vector3.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define FAST_MATH_SSE
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#define FAST_MATH_NEON
+#include <arm_neon.h>
+#endif
+
+namespace dae
+{
+	//Approximations for the shading code's fast-math mode, in exchange for the sqrt, divide and powf they replace.
+	//RSqrt and Reciprocal refine the hardware estimate with one Newton-Raphson step on both SSE and NEON, which takes SSE's
+	//12 bits to about 22 and NEON's 8 bits to about 16. Log2 and Exp2 are short polynomials near 1e-6 everywhere.
+	//Renderer::CompareFastMath measures what this does to the image
+	namespace FastMath
+	{
+		constexpr float InvPi{ 1.f / 3.14159265358979323846f };
+
+		//1 / sqrt(x) from the hardware estimate e and one Newton-Raphson step, e * (1.5 - x / 2 * e * e)
+		inline float RSqrt(float x)
+		{
+#if defined(FAST_MATH_SSE)
+			const __m128 value{ _mm_set_ss(x) };
+			const __m128 estimate{ _mm_rsqrt_ss(value) };
+			const __m128 halfValueEstimateSquared{ _mm_mul_ss(_mm_mul_ss(_mm_set_ss(.5f), value), _mm_mul_ss(estimate, estimate)) };
+			return _mm_cvtss_f32(_mm_mul_ss(estimate, _mm_sub_ss(_mm_set_ss(1.5f), halfValueEstimateSquared)));
+#elif defined(FAST_MATH_NEON)
+			const float32x2_t value{ vdup_n_f32(x) };
+			const float32x2_t estimate{ vrsqrte_f32(value) };
+			return vget_lane_f32(vmul_f32(estimate, vrsqrts_f32(vmul_f32(value, estimate), estimate)), 0);
+#else
+			return 1.f / sqrtf(x);
+#endif
+		}
+
+		//1 / x from the hardware estimate e and one Newton-Raphson step, e * (2 - x * e)
+		inline float Reciprocal(float x)
+		{
+#if defined(FAST_MATH_SSE)
+			const __m128 value{ _mm_set_ss(x) };
+			const __m128 estimate{ _mm_rcp_ss(value) };
+			return _mm_cvtss_f32(_mm_mul_ss(estimate, _mm_sub_ss(_mm_set_ss(2.f), _mm_mul_ss(value, estimate))));
+#elif defined(FAST_MATH_NEON)
+			const float32x2_t value{ vdup_n_f32(x) };
+			const float32x2_t estimate{ vrecpe_f32(value) };
+			return vget_lane_f32(vmul_f32(estimate, vrecps_f32(value, estimate)), 0);
+#else
+			return 1.f / x;
+#endif
+		}
+
+		//log2 of a positive, normal x. The exponent comes from the bits, the mantissa, moved to [sqrt(1/2), sqrt(2)), through
+		//ln(m) = 2 atanh((m - 1) / (m + 1)), whose series is down to 1e-8 after four terms there
+		inline float Log2(float x)
+		{
+			const uint32_t bits{ std::bit_cast<uint32_t>(x) };
+			//subtracting sqrt(1/2)'s bits first puts mantissas above sqrt(2) in the next exponent
+			const int32_t offsetBits{ int32_t(bits - 0x3f3504f3u) };
+			const int32_t exponent{ offsetBits >> 23 };
+			const float m{ std::bit_cast<float>(uint32_t(int32_t(bits) - (exponent << 23))) };
+
+			const float t{ (m - 1.f) / (m + 1.f) };
+			const float t2{ t * t };
+			const float lnM{ 2.f * t * (1.f + t2 * (1.f / 3.f + t2 * (1.f / 5.f + t2 * (1.f / 7.f)))) };
+			return float(exponent) + lnM * 1.44269504088896340736f;
+		}
+
+		//2^x, 0 below the smallest normal float. The integer part goes into the exponent bits, 2^f for the rest in
+		//[-1/2, 1/2] is the Taylor series of e^(f ln 2) up to the sixth power
+		inline float Exp2(float x)
+		{
+			if (x < -126.f) return 0.f;
+			if (x > 127.f) return INFINITY;
+
+			const int32_t rounded{ int32_t(x < 0.f ? x - .5f : x + .5f) };
+			const float f{ (x - float(rounded)) * 0.693147180559945309417f };
+			const float series{ 1.f + f * (1.f + f * (1.f / 2.f + f * (1.f / 6.f + f * (1.f / 24.f + f * (1.f / 120.f + f * (1.f / 720.f)))))) };
+			return series * std::bit_cast<float>(uint32_t(rounded + 127) << 23);
+		}
+
+		//base^exponent for base >= 0, through Exp2(exponent * Log2(base)). 0 for a base of 0, like powf with a positive exponent
+		inline float Pow(float base, float exponent)
+		{
+			if (base <= 0.f) return 0.f;
+			return Exp2(exponent * Log2(base));
+		}
+
+		inline Vector3 Normalized(const Vector3& v)
+		{
+			return v * RSqrt(Vector3::Dot(v, v));
+		}
+	}
+}
@@ -0,0 +1,98 @@
+#include "FramePipeline.h"
+#include "Renderer.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace dae
+{
+	FramePipeline::FramePipeline(Renderer* pRenderer, uint32_t latency) :
+		m_pRenderer(pRenderer),
+		m_Latency(std::min(latency, 1u))
+	{
+		if (m_Latency > 0) m_Thread = std::thread{ &FramePipeline::RenderLoop, this };
+	}
+
+	FramePipeline::~FramePipeline()
+	{
+		if (!m_Thread.joinable()) return;
+
+		{
+			std::lock_guard lock{ m_Mutex };
+			m_IsStopping = true;
+		}
+		m_WakeCondition.notify_all();
+		m_Thread.join();
+	}
+
+	void FramePipeline::Wait()
+	{
+		std::unique_lock lock{ m_Mutex };
+		m_DoneCondition.wait(lock, [this]() { return !m_IsRendering; });
+
+		//the front buffer's frame has been presented by now, the one that just finished takes its place and the renderer
+		//writes the next one over the old pixels. Done before anything can change the render scale, which decides which
+		//of the renderer's buffers holds the frame
+		if (m_Latency > 0 && m_HasFinishedFrame)
+		{
+			m_pRenderer->SwapPixels(m_FrontBuffer);
+			m_HasFinishedFrame = false;
+			m_HasFrontBuffer = true;
+		}
+	}
+
+	void FramePipeline::Render(Scene* pScene)
+	{
+		if (m_Latency == 0)
+		{
+			m_RenderMs = RenderFrame(pScene);
+			m_HasFinishedFrame = true;
+			return;
+		}
+
+		{
+			std::lock_guard lock{ m_Mutex };
+			m_pPendingScene = pScene;
+			m_IsRendering = true;
+		}
+		m_WakeCondition.notify_all();
+	}
+
+	const uint32_t* FramePipeline::GetFrontBuffer() const
+	{
+		if (m_Latency == 0) return m_HasFinishedFrame ? m_pRenderer->GetPixels() : nullptr;
+		return m_HasFrontBuffer ? m_FrontBuffer.data() : nullptr;
+	}
+
+	void FramePipeline::RenderLoop()
+	{
+		while (true)
+		{
+			Scene* pScene{};
+			{
+				std::unique_lock lock{ m_Mutex };
+				m_WakeCondition.wait(lock, [this]() { return m_IsStopping || m_pPendingScene; });
+				if (m_IsStopping) return;
+				pScene = m_pPendingScene;
+				m_pPendingScene = nullptr;
+			}
+
+			const double renderMs{ RenderFrame(pScene) };
+
+			{
+				std::lock_guard lock{ m_Mutex };
+				m_RenderMs = renderMs;
+				m_HasFinishedFrame = true;
+				m_IsRendering = false;
+			}
+			m_DoneCondition.notify_all();
+		}
+	}
+
+	double FramePipeline::RenderFrame(Scene* pScene)
+	{
+		const auto start{ std::chrono::steady_clock::now() };
+		m_pRenderer->Render(pScene);
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+}
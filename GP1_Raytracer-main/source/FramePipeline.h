@@ -0,0 +1,68 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dae
+{
+	class Renderer;
+	class Scene;
+
+	//Double-buffered presentation: with a latency of one frame, frame N is presented from a front buffer while frame N+1
+	//renders on a thread of its own. Presenting stays on the calling thread, SDL wants its window on the main thread
+	class FramePipeline final
+	{
+	public:
+		/**
+		 * \param latency frames between rendering and presenting. 0 renders and presents one after the other, 1 overlaps
+		 * them. More is clamped to 1: the scene is updated between renders, so they cannot overlap each other, and a
+		 * deeper queue would only delay frames without rendering any more of them
+		 */
+		FramePipeline(Renderer* pRenderer, uint32_t latency);
+		~FramePipeline();
+
+		FramePipeline(const FramePipeline&) = delete;
+		FramePipeline(FramePipeline&&) noexcept = delete;
+		FramePipeline& operator=(const FramePipeline&) = delete;
+		FramePipeline& operator=(FramePipeline&&) noexcept = delete;
+
+		//Blocks until the frame in flight is rendered and, with a latency of 1, moves it to the front buffer. Until then
+		//neither the renderer nor the scene may be touched. Its stats, like GetRenderMs, stay readable until the next Render
+		void Wait();
+		//Renders the scene as it is now, in the background with a latency of 1. Call Wait first
+		void Render(Scene* pScene);
+		//The frame to present, latency frames behind the last Render, 0xAARRGGBB at the renderer's output size.
+		//nullptr until there is one. With a latency of 0 it is the renderer's own pixels, only valid until its render
+		//scale changes
+		const uint32_t* GetFrontBuffer() const;
+
+		uint32_t GetLatency() const { return m_Latency; }
+		//How long the last finished frame took to render, only between Wait and Render
+		double GetRenderMs() const { return m_RenderMs; }
+
+	private:
+		void RenderLoop();
+		//returns how long it took in milliseconds
+		double RenderFrame(Scene* pScene);
+
+		Renderer* m_pRenderer{};
+		uint32_t m_Latency{};
+
+		//what is presented, swapped with the renderer's pixels once the frame after it is done
+		std::vector<uint32_t> m_FrontBuffer{};
+		bool m_HasFrontBuffer{ false };
+
+		std::thread m_Thread{};
+		std::mutex m_Mutex{};
+		std::condition_variable m_WakeCondition{};
+		std::condition_variable m_DoneCondition{};
+		Scene* m_pPendingScene{};
+		bool m_IsRendering{ false };
+		bool m_IsStopping{ false };
+		//written by the render thread under m_Mutex. Rendered, but not swapped to the front yet
+		bool m_HasFinishedFrame{ false };
+		double m_RenderMs{};
+	};
+}
@@ -0,0 +1,133 @@
+#include "LightTree.h"
+
+#include <algorithm>
+
+namespace dae
+{
+	namespace
+	{
+		float GetPower(const Light& light)
+		{
+			return light.intensity * (0.2126f * light.color.r + 0.7152f * light.color.g + 0.0722f * light.color.b);
+		}
+	}
+
+	void LightTree::Build(const std::vector<Light>& lights)
+	{
+		m_Nodes.clear();
+		m_LightIndices.resize(lights.size());
+		if (lights.empty()) return;
+
+		for (uint32_t i{}; i < lights.size(); ++i) m_LightIndices[i] = i;
+
+		//a binary tree with one light per leaf
+		m_Nodes.reserve(lights.size() * 2 - 1);
+		m_Nodes.emplace_back();
+		Subdivide(0, 0, static_cast<uint32_t>(lights.size()), lights);
+	}
+
+	void LightTree::Subdivide(uint32_t nodeIndex, uint32_t first, uint32_t count, const std::vector<Light>& lights)
+	{
+		Vector3 minAABB{ FLT_MAX, FLT_MAX, FLT_MAX };
+		Vector3 maxAABB{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		float pointPower{}, directionalPower{};
+		for (uint32_t i{ first }; i < first + count; ++i)
+		{
+			const Light& light{ lights[m_LightIndices[i]] };
+			minAABB = Vector3::Min(minAABB, light.origin);
+			maxAABB = Vector3::Max(maxAABB, light.origin);
+			(light.type == LightType::Point ? pointPower : directionalPower) += GetPower(light);
+		}
+
+		{
+			LightTreeNode& node{ m_Nodes[nodeIndex] };
+			node.minAABB = minAABB;
+			node.maxAABB = maxAABB;
+			node.lightCount = count;
+			node.pointPower = pointPower;
+			node.directionalPower = directionalPower;
+			if (count == 1)
+			{
+				node.leftFirst = m_LightIndices[first];
+				return;
+			}
+		}
+
+		//median split along the longest axis, lights are few and cheap to sort compared to the rays they save
+		const Vector3 extent{ maxAABB - minAABB };
+		int axis{ 0 };
+		if (extent.y > extent.x) axis = 1;
+		if (extent.z > extent[axis]) axis = 2;
+
+		const uint32_t leftCount{ count / 2 };
+		std::nth_element(m_LightIndices.begin() + first, m_LightIndices.begin() + first + leftCount, m_LightIndices.begin() + first + count,
+			[&](uint32_t a, uint32_t b) { return lights[a].origin[axis] < lights[b].origin[axis]; });
+
+		//emplace_back can move the nodes, the reference above is not used across it
+		const uint32_t leftChild{ static_cast<uint32_t>(m_Nodes.size()) };
+		m_Nodes.emplace_back();
+		m_Nodes.emplace_back();
+		m_Nodes[nodeIndex].leftFirst = leftChild;
+
+		Subdivide(leftChild, first, leftCount, lights);
+		Subdivide(leftChild + 1, first + leftCount, count - leftCount, lights);
+	}
+
+	float LightTree::GetImportance(const LightTreeNode& node, const Vector3& position, const Vector3& normal, bool isFrontFacingOnly) const
+	{
+		//the dot product with the normal is linear, so the lights are all behind the surface when every corner is
+		if (isFrontFacingOnly)
+		{
+			bool isAnyInFront{ false };
+			for (int corner{}; corner < 8 && !isAnyInFront; ++corner)
+			{
+				const Vector3 point{ corner & 1 ? node.maxAABB.x : node.minAABB.x, corner & 2 ? node.maxAABB.y : node.minAABB.y, corner & 4 ? node.maxAABB.z : node.minAABB.z };
+				isAnyInFront = Vector3::Dot(normal, point - position) > 0.f;
+			}
+			if (!isAnyInFront) return 0.f;
+		}
+
+		//distance to the center, but a cluster the point sits in or next to counts as no closer than its own radius
+		const Vector3 center{ (node.minAABB + node.maxAABB) * .5f };
+		const float distanceSqr{ std::max((center - position).SqrMagnitude(), (node.maxAABB - node.minAABB).SqrMagnitude() * .25f) };
+		return node.pointPower / std::max(distanceSqr, 1e-6f) + node.directionalPower;
+	}
+
+	uint32_t LightTree::Sample(const Vector3& position, const Vector3& normal, bool isFrontFacingOnly, float u, float& pdf) const
+	{
+		pdf = 0.f;
+		if (m_Nodes.empty() || GetImportance(m_Nodes[0], position, normal, isFrontFacingOnly) == 0.f) return InvalidLight;
+
+		//every light that can add something keeps a non zero chance, which keeps the estimate unbiased
+		pdf = 1.f;
+		uint32_t nodeIndex{};
+		while (!m_Nodes[nodeIndex].IsLeaf())
+		{
+			const uint32_t leftChild{ m_Nodes[nodeIndex].leftFirst };
+			const float leftImportance{ GetImportance(m_Nodes[leftChild], position, normal, isFrontFacingOnly) };
+			const float rightImportance{ GetImportance(m_Nodes[leftChild + 1], position, normal, isFrontFacingOnly) };
+			if (leftImportance + rightImportance == 0.f)
+			{
+				pdf = 0.f;
+				return InvalidLight;
+			}
+
+			//u picks the child and is then stretched over that child's share, so one number lasts the whole walk
+			const float leftProbability{ leftImportance / (leftImportance + rightImportance) };
+			if (u < leftProbability)
+			{
+				u /= leftProbability;
+				pdf *= leftProbability;
+				nodeIndex = leftChild;
+			}
+			else
+			{
+				u = (u - leftProbability) / (1.f - leftProbability);
+				pdf *= 1.f - leftProbability;
+				nodeIndex = leftChild + 1;
+			}
+			u = std::min(u, 0x1.fffffep-1f);
+		}
+		return m_Nodes[nodeIndex].leftFirst;
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "DataTypes.h"
+
+namespace dae
+{
+	struct LightTreeNode
+	{
+		Vector3 minAABB{};
+		uint32_t leftFirst{}; //interior: index of left child (right = left + 1), leaf: index of the light in the scene
+		Vector3 maxAABB{};
+		uint32_t lightCount{}; //1 for leaves
+		float pointPower{}; //summed intensity * luminance of the point lights below, falls off with the squared distance
+		float directionalPower{}; //same for the directional lights, which do not fall off
+
+		bool IsLeaf() const { return lightCount == 1; }
+	};
+
+	//Bounding volume hierarchy over the lights of a scene, for picking one light at random with a probability that follows
+	//how much it can add to a given point. Lights are placed at their origin, as the shading does for both light types
+	class LightTree final
+	{
+	public:
+		LightTree() = default;
+		~LightTree() = default;
+
+		static constexpr uint32_t InvalidLight{ UINT32_MAX };
+
+		void Build(const std::vector<Light>& lights);
+
+		/**
+		 * \brief Walks down the tree, at every node picking a child by its estimated contribution to the point
+		 * \param isFrontFacingOnly lights behind the surface add nothing, the tree never picks them
+		 * \param u uniform random number in [0, 1)
+		 * \param pdf set to the probability the returned light had to be picked, the estimator divides by it
+		 * \return index of the light in the scene, InvalidLight when no light can reach the point
+		 */
+		uint32_t Sample(const Vector3& position, const Vector3& normal, bool isFrontFacingOnly, float u, float& pdf) const;
+
+		const std::vector<LightTreeNode>& GetNodes() const { return m_Nodes; }
+		uint32_t GetLightCount() const { return static_cast<uint32_t>(m_LightIndices.size()); }
+
+	private:
+		void Subdivide(uint32_t nodeIndex, uint32_t first, uint32_t count, const std::vector<Light>& lights);
+		float GetImportance(const LightTreeNode& node, const Vector3& position, const Vector3& normal, bool isFrontFacingOnly) const;
+
+		std::vector<LightTreeNode> m_Nodes{};
+		std::vector<uint32_t> m_LightIndices{};
+	};
+}
@@ -1,10 +1,179 @@
 #pragma once
+#include <cstdint>
+
 #include "Math.h"
 #include "DataTypes.h"
 #include "BRDFs.h"
+#include "FastMath.h"
 
 namespace dae
 {
+#pragma region Material DATA
+	enum class MaterialType : uint8_t
+	{
+		SolidColor,
+		Lambert,
+		LambertPhong,
+		CookTorrence
+	};
+
+	//The parameters of every kind of material in one flat record. The scene keeps a table of these next to its materials,
+	//indexed by the same materialIndex, so the renderer can shade without going through a virtual call per light
+	struct MaterialData
+	{
+		ColorRGB color{ colors::White }; //solid color, diffuse color or albedo
+		float diffuseReflectance{ 1.f }; //kd
+		float specularReflectance{}; //ks
+		float phongExponent{ 1.f };
+		float metalness{};
+		float roughness{ 1.f };
+		MaterialType type{ MaterialType::SolidColor };
+
+		//Cook-Torrance terms that only depend on the parameters, worked out once instead of for every light of every hit
+		ColorRGB f0{}; //base reflectivity
+		ColorRGB oneMinusF0{};
+		float alphaSqr{}; //GGX alpha = roughness^2, squared
+		float kDirect{}; //Schlick-GGX k for direct light
+		bool isMetal{};
+	};
+
+	//The BRDF of every material type as a plain function of its data, one per type so a batch of hits of one type calls
+	//the same code without branching. n is the surface normal, l points towards the light and v towards the camera
+	namespace MaterialShading
+	{
+		inline ColorRGB SolidColor(const MaterialData& material)
+		{
+			return material.color;
+		}
+
+		inline ColorRGB Lambert(const MaterialData& material)
+		{
+			return BRDF::Lambert(material.diffuseReflectance, material.color);
+		}
+
+		inline ColorRGB LambertPhong(const MaterialData& material, const Vector3& n, const Vector3& l, const Vector3& v)
+		{
+			return { BRDF::Lambert(material.diffuseReflectance, material.color) + BRDF::Phong(material.specularReflectance, material.phongExponent, l, -v, n) };
+		}
+
+		//Fills in the derived Cook-Torrence terms of MaterialData, the same values BRDF:: works out from the parameters
+		inline void PrepareCookTorrence(MaterialData& material)
+		{
+			const float a{ material.roughness * material.roughness };
+			material.isMetal = material.metalness != 0.0f;
+			material.f0 = material.isMetal ? material.color : ColorRGB(0.04f, 0.04f, 0.04f);
+			material.oneMinusF0 = ColorRGB(1.f, 1.f, 1.f) - material.f0;
+			material.alphaSqr = a * a;
+			material.kDirect = Square(a + 1) / 8.0f;
+		}
+
+		//BRDF::FresnelFunction_Schlick, NormalDistribution_GGX and GeometryFunction_Smith with the prepared terms
+		inline ColorRGB CookTorrence(const MaterialData& material, const Vector3& n, const Vector3& l, const Vector3& v)
+		{
+			const Vector3 plusVL = v + l;
+			const float magnitude{ sqrtf(Vector3::Dot(plusVL, plusVL)) }; //Magnitude, without the call
+			const Vector3 h{ plusVL.x / magnitude, plusVL.y / magnitude, plusVL.z / magnitude };
+
+			const float    dotHV{ 1.0f - std::max(0.0f, Vector3::Dot(h, v)) };
+			const ColorRGB f	{ material.f0 + material.oneMinusF0 * (dotHV * dotHV * dotHV * dotHV * dotHV) };
+
+			const float    dotNH{ Vector3::Dot(n, h) };
+			const float    divisor{ (dotNH * dotNH) * (material.alphaSqr - 1.f) + 1.f };
+			const float    d	{ material.alphaSqr / (PI * (divisor * divisor)) };
+
+			const float    dotNV{ Vector3::Dot(v,n) };
+			const float    dotNL{ Vector3::Dot(l,n) };
+			const float    clampedNV{ std::max(dotNV, 0.f) }, clampedNL{ std::max(dotNL, 0.f) };
+			const float    g	{ clampedNV / (clampedNV * (1.0f - material.kDirect) + material.kDirect) * (clampedNL / (clampedNL * (1.0f - material.kDirect) + material.kDirect)) };
+
+			ColorRGB color{ f * d * g };
+
+			ColorRGB specular{ color / (4.0f * dotNV * dotNL) };
+			specular.MaxToOne();
+
+			if (material.isMetal) return specular;
+			return specular + BRDF::Lambert(ColorRGB(1.f, 1.f, 1.f) - f, material.color);
+		}
+
+		//Fast-math versions: reciprocal square roots, reciprocal multiplies and a polynomial pow instead of sqrt, divides and
+		//powf, see FastMath. Within about 1e-3 of the exact functions, a level of an 8 bit pixel at most
+		inline ColorRGB LambertFast(const MaterialData& material)
+		{
+			return material.color * (material.diffuseReflectance * FastMath::InvPi);
+		}
+
+		inline ColorRGB LambertPhongFast(const MaterialData& material, const Vector3& n, const Vector3& l, const Vector3& v)
+		{
+			//BRDF::Phong, reflecting l around n and comparing it with the direction v points away from
+			const Vector3 reflected{ Vector3::Reflect(l, n) };
+			const float cosAlpha{ std::max(-Vector3::Dot(reflected, v), 0.f) };
+			const float specular{ material.specularReflectance * FastMath::Pow(cosAlpha, material.phongExponent) };
+			return LambertFast(material) + ColorRGB{ specular, specular, specular };
+		}
+
+		inline ColorRGB CookTorrenceFast(const MaterialData& material, const Vector3& n, const Vector3& l, const Vector3& v)
+		{
+			//h is never normalized, its dot products are scaled by its (squared) length instead
+			const Vector3  plusVL{ v + l };
+			const float    sqrLength{ Vector3::Dot(plusVL, plusVL) };
+
+			const float    dotHV{ 1.0f - std::max(0.0f, Vector3::Dot(plusVL, v) * FastMath::RSqrt(sqrLength)) };
+			const ColorRGB f	{ material.f0 + material.oneMinusF0 * (dotHV * dotHV * dotHV * dotHV * dotHV) };
+
+			//a smooth surface's highlight lives in the last bits of dotNH^2, so it gets a real divide
+			const float    dotNH{ Vector3::Dot(n, plusVL) };
+			const float    divisor{ (dotNH * dotNH / sqrLength) * (material.alphaSqr - 1.f) + 1.f };
+			const float    d	{ material.alphaSqr * FastMath::Reciprocal(PI * (divisor * divisor)) };
+
+			const float    dotNV{ Vector3::Dot(v,n) };
+			const float    dotNL{ Vector3::Dot(l,n) };
+			const float    clampedNV{ std::max(dotNV, 0.f) }, clampedNL{ std::max(dotNL, 0.f) };
+			const float    g	{ clampedNV * clampedNL * FastMath::Reciprocal((clampedNV * (1.0f - material.kDirect) + material.kDirect) * (clampedNL * (1.0f - material.kDirect) + material.kDirect)) };
+
+			ColorRGB specular{ f * (d * g * FastMath::Reciprocal(4.0f * dotNV * dotNL)) };
+			specular.MaxToOne();
+
+			if (material.isMetal) return specular;
+			return specular + (ColorRGB(1.f, 1.f, 1.f) - f) * material.color * FastMath::InvPi;
+		}
+
+		//For single hits, batches switch once and call the functions above directly
+		inline ColorRGB Shade(const MaterialData& material, const Vector3& n, const Vector3& l, const Vector3& v)
+		{
+			switch (material.type)
+			{
+			case MaterialType::SolidColor: return SolidColor(material);
+			case MaterialType::Lambert: return Lambert(material);
+			case MaterialType::LambertPhong: return LambertPhong(material, n, l, v);
+			case MaterialType::CookTorrence: return CookTorrence(material, n, l, v);
+			}
+			return {};
+		}
+
+		//Calls function once with the BRDF of the material's type as a callable (n, l, v), so everything function shades
+		//with it is compiled for that type and the switch is paid once. IsFastMath hands out the fast-math versions
+		template<bool IsFastMath = false, typename Function>
+		void Dispatch(const MaterialData& material, const Function& function)
+		{
+			switch (material.type)
+			{
+			case MaterialType::SolidColor:
+				function([&](const Vector3&, const Vector3&, const Vector3&) { return SolidColor(material); });
+				break;
+			case MaterialType::Lambert:
+				function([&](const Vector3&, const Vector3&, const Vector3&) { return IsFastMath ? LambertFast(material) : Lambert(material); });
+				break;
+			case MaterialType::LambertPhong:
+				function([&](const Vector3& n, const Vector3& l, const Vector3& v) { return IsFastMath ? LambertPhongFast(material, n, l, v) : LambertPhong(material, n, l, v); });
+				break;
+			case MaterialType::CookTorrence:
+				function([&](const Vector3& n, const Vector3& l, const Vector3& v) { return IsFastMath ? CookTorrenceFast(material, n, l, v) : CookTorrence(material, n, l, v); });
+				break;
+			}
+		}
+	}
+#pragma endregion
+
 #pragma region Material BASE
 	class Material
 	{
@@ -24,7 +193,13 @@ namespace dae
 		 * \param v view direction
 		 * \return color
 		 */
-		virtual ColorRGB Shade(const HitRecord& hitRecord = {}, const Vector3& l = {}, const Vector3& v = {}) = 0;
+		ColorRGB Shade(const HitRecord& hitRecord = {}, const Vector3& l = {}, const Vector3& v = {}) const
+		{
+			return MaterialShading::Shade(GetData(), hitRecord.normal, l, v);
+		}
+
+		//The material's type and parameters, what the scene's material table stores
+		virtual MaterialData GetData() const = 0;
 	};
 #pragma endregion
 
@@ -38,9 +213,9 @@ namespace dae
 		{
 		}
 
-		ColorRGB Shade(const HitRecord& hitRecord, const Vector3& l, const Vector3& v) override
+		MaterialData GetData() const override
 		{
-			return m_Color;
+			return { .color = m_Color, .type = MaterialType::SolidColor };
 		}
 
 	private:
@@ -57,11 +232,9 @@ namespace dae
 		Material_Lambert(const ColorRGB& diffuseColor, float diffuseReflectance) :
 			m_DiffuseColor(diffuseColor), m_DiffuseReflectance(diffuseReflectance){}
 
-		ColorRGB Shade(const HitRecord& hitRecord = {}, const Vector3& l = {}, const Vector3& v = {}) override
+		MaterialData GetData() const override
 		{
-			//todo: W3
-			//assert(false && "Not Implemented Yet");
-			return BRDF::Lambert(m_DiffuseReflectance, m_DiffuseColor);
+			return { .color = m_DiffuseColor, .diffuseReflectance = m_DiffuseReflectance, .type = MaterialType::Lambert };
 		}
 
 	private:
@@ -82,10 +255,10 @@ namespace dae
 		{
 		}
 
-		ColorRGB Shade(const HitRecord& hitRecord = {}, const Vector3& l = {}, const Vector3& v = {}) override
+		MaterialData GetData() const override
 		{
-			//todo: W3
-			return { BRDF::Lambert(m_DiffuseReflectance, m_DiffuseColor) + BRDF::Phong(m_SpecularReflectance, m_PhongExponent, l, -v, hitRecord.normal) };
+			return { .color = m_DiffuseColor, .diffuseReflectance = m_DiffuseReflectance, .specularReflectance = m_SpecularReflectance,
+				.phongExponent = m_PhongExponent, .type = MaterialType::LambertPhong };
 		}
 
 	private:
@@ -106,27 +279,11 @@ namespace dae
 		{
 		}
 
-		ColorRGB Shade(const HitRecord& hitRecord = {}, const Vector3& l = {}, const Vector3& v = {}) override
+		MaterialData GetData() const override
 		{
-			//todo: W3
-			const Vector3 plusVL = v + l;
-			const Vector3 h{ plusVL / plusVL.Magnitude() };
-
-			const ColorRGB f0{ m_Metalness == 0.0f ? ColorRGB(0.04f, 0.04f, 0.04f) : m_Albedo };
-
-			const ColorRGB f	{ BRDF::FresnelFunction_Schlick(h, v,f0) };
-			const float    d	{ BRDF::NormalDistribution_GGX(hitRecord.normal, h, m_Roughness) };
-			const float    g	{ BRDF::GeometryFunction_Smith(hitRecord.normal, v, l, m_Roughness) };
-
-			ColorRGB color{ f * d * g };
-
-			ColorRGB specular{ color / (4.0f * Vector3::Dot(v,hitRecord.normal) * Vector3::Dot(l,hitRecord.normal)) };
-			specular.MaxToOne();
-
-			const ColorRGB kd{ m_Metalness == 0.0f ? ColorRGB(1.f, 1.f, 1.f) - f : ColorRGB{0,0,0}};
-			const ColorRGB diffuse{ BRDF::Lambert(kd,m_Albedo) };
-
-			return specular + diffuse;
+			MaterialData data{ .color = m_Albedo, .metalness = m_Metalness, .roughness = m_Roughness, .type = MaterialType::CookTorrence };
+			MaterialShading::PrepareCookTorrence(data);
+			return data;
 		}
 
 	private:
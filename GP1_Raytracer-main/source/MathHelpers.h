@@ -1,5 +1,6 @@
 #pragma once
 #include <cmath>
+#include <cstdint>
 #include <float.h>
 
 namespace dae
@@ -28,4 +29,21 @@ namespace dae
 	{
 		return abs(a - b) < epsilon;
 	}
+
+	//Moves bit i of the low 10 bits of a to bit 3 * i, so three of these can be interleaved
+	inline uint32_t SpreadBits3(uint32_t a)
+	{
+		a &= 0x3ff;
+		a = (a | (a << 16)) & 0x030000ff;
+		a = (a | (a << 8)) & 0x0300f00f;
+		a = (a | (a << 4)) & 0x030c30c3;
+		a = (a | (a << 2)) & 0x09249249;
+		return a;
+	}
+
+	//Position of the cell (x, y, z) of a 1024^3 grid along the Z-order curve, cells close in space get close codes
+	inline uint32_t MortonCode3(uint32_t x, uint32_t y, uint32_t z)
+	{
+		return SpreadBits3(x) | (SpreadBits3(y) << 1) | (SpreadBits3(z) << 2);
+	}
 }
\ No newline at end of file
@@ -1,4 +1,7 @@
 #pragma once
+#include <cassert>
+#include <cmath>
+
 #include "Vector3.h"
 #include "Vector4.h"
 
@@ -6,50 +9,56 @@ namespace dae {
 	struct Matrix
 	{
 		Matrix() = default;
-		Matrix(
+		constexpr Matrix(
 			const Vector3& xAxis,
 			const Vector3& yAxis,
 			const Vector3& zAxis,
 			const Vector3& t);
 
-		Matrix(
+		constexpr Matrix(
 			const Vector4& xAxis,
 			const Vector4& yAxis,
 			const Vector4& zAxis,
 			const Vector4& t);
 
-		Matrix(const Matrix& m);
+		Matrix(const Matrix& m) = default;
+		Matrix& operator=(const Matrix& m) = default;
 
-		Vector3 TransformVector(const Vector3& v) const;
-		Vector3 TransformVector(float x, float y, float z) const;
-		Vector3 TransformPoint(const Vector3& p) const;
-		Vector3 TransformPoint(float x, float y, float z) const;
-		const Matrix& Transpose();
+		constexpr Vector3 TransformVector(const Vector3& v) const;
+		constexpr Vector3 TransformVector(float x, float y, float z) const;
+		constexpr Vector3 TransformPoint(const Vector3& p) const;
+		constexpr Vector3 TransformPoint(float x, float y, float z) const;
+		constexpr const Matrix& Transpose();
+		constexpr const Matrix& Inverse();
 
-		Vector3 GetAxisX() const;
-		Vector3 GetAxisY() const;
-		Vector3 GetAxisZ() const;
-		Vector3 GetTranslation() const;
+		constexpr Vector3 GetAxisX() const;
+		constexpr Vector3 GetAxisY() const;
+		constexpr Vector3 GetAxisZ() const;
+		constexpr Vector3 GetTranslation() const;
 
-		static Matrix CreateTranslation(float x, float y, float z);
-		static Matrix CreateTranslation(const Vector3& t);
+		static constexpr Matrix CreateTranslation(float x, float y, float z);
+		static constexpr Matrix CreateTranslation(const Vector3& t);
 		static Matrix CreateRotationX(float pitch);
 		static Matrix CreateRotationY(float yaw);
 		static Matrix CreateRotationZ(float roll);
 		static Matrix CreateRotation(float pitch, float yaw, float roll);
 		static Matrix CreateRotation(const Vector3& r);
-		static Matrix CreateScale(float sx, float sy, float sz);
-		static Matrix CreateScale(const Vector3& s);
-		static Matrix Transpose(const Matrix& m);
+		static constexpr Matrix CreateScale(float sx, float sy, float sz);
+		static constexpr Matrix CreateScale(const Vector3& s);
+		static constexpr Matrix Transpose(const Matrix& m);
+		static constexpr Matrix Inverse(const Matrix& m);
 
-		Vector4& operator[](int index);
-		Vector4 operator[](int index) const;
-		Matrix operator*(const Matrix& m) const;
-		const Matrix& operator*=(const Matrix& m);
+		constexpr Vector4& operator[](int index);
+		constexpr Vector4 operator[](int index) const;
+		constexpr Matrix operator*(const Matrix& m) const;
+		constexpr const Matrix& operator*=(const Matrix& m);
+		constexpr bool operator==(const Matrix& m) const;
 
 	private:
+		//Row r of this * m, the rows of m scaled by the components of r and summed in the order of Vector4::Dot
+		static constexpr Vector4 MultiplyRow(const Vector4& r, const Matrix& m);
 
-		//Row-Major Matrix
+		//Row-Major Matrix, every row is an aligned Vector4 so the transforms work on whole rows at once
 		Vector4 data[4]
 		{
 			{1,0,0,0}, //xAxis
@@ -63,4 +72,200 @@ namespace dae {
 		// v2x v2y v2z v2w
 		// v3x v3y v3z v3w
 	};
-}
\ No newline at end of file
+
+	constexpr Matrix::Matrix(const Vector3& xAxis, const Vector3& yAxis, const Vector3& zAxis, const Vector3& t) :
+		Matrix({ xAxis, 0 }, { yAxis, 0 }, { zAxis, 0 }, { t, 1 })
+	{
+	}
+
+	constexpr Matrix::Matrix(const Vector4& xAxis, const Vector4& yAxis, const Vector4& zAxis, const Vector4& t) :
+		data{ xAxis, yAxis, zAxis, t }
+	{
+	}
+
+	constexpr Vector3 Matrix::TransformVector(const Vector3& v) const
+	{
+		return TransformVector(v[0], v[1], v[2]);
+	}
+
+	constexpr Vector3 Matrix::TransformVector(float x, float y, float z) const
+	{
+		//Per component: data[0].x * x + data[1].x * y + data[2].x * z
+		return data[0] * x + data[1] * y + data[2] * z;
+	}
+
+	constexpr Vector3 Matrix::TransformPoint(const Vector3& p) const
+	{
+		return TransformPoint(p[0], p[1], p[2]);
+	}
+
+	constexpr Vector3 Matrix::TransformPoint(float x, float y, float z) const
+	{
+		//Per component: data[0].x * x + data[1].x * y + data[2].x * z + data[3].x
+		return data[0] * x + data[1] * y + data[2] * z + data[3];
+	}
+
+	constexpr const Matrix& Matrix::Transpose()
+	{
+		Matrix result{};
+		for (int r{ 0 }; r < 4; ++r)
+		{
+			for (int c{ 0 }; c < 4; ++c)
+			{
+				result[r][c] = data[c][r];
+			}
+		}
+
+		*this = result;
+
+		return *this;
+	}
+
+	constexpr Matrix Matrix::Transpose(const Matrix& m)
+	{
+		Matrix out{ m };
+		out.Transpose();
+
+		return out;
+	}
+
+	constexpr const Matrix& Matrix::Inverse()
+	{
+		//Affine inverse: the 3x3 part is inverted through its adjugate, the translation is undone afterwards
+		const Vector3 xAxis{ GetAxisX() };
+		const Vector3 yAxis{ GetAxisY() };
+		const Vector3 zAxis{ GetAxisZ() };
+		const Vector3 translation{ GetTranslation() };
+
+		const Vector3 yz{ Vector3::Cross(yAxis, zAxis) };
+		const Vector3 zx{ Vector3::Cross(zAxis, xAxis) };
+		const Vector3 xy{ Vector3::Cross(xAxis, yAxis) };
+		const float invDeterminant{ 1.f / Vector3::Dot(xAxis, yz) };
+
+		data[0] = { yz.x * invDeterminant, zx.x * invDeterminant, xy.x * invDeterminant, 0 };
+		data[1] = { yz.y * invDeterminant, zx.y * invDeterminant, xy.y * invDeterminant, 0 };
+		data[2] = { yz.z * invDeterminant, zx.z * invDeterminant, xy.z * invDeterminant, 0 };
+		data[3] = { -TransformVector(translation), 1 };
+
+		return *this;
+	}
+
+	constexpr Matrix Matrix::Inverse(const Matrix& m)
+	{
+		Matrix out{ m };
+		out.Inverse();
+
+		return out;
+	}
+
+	constexpr Vector3 Matrix::GetAxisX() const
+	{
+		return data[0];
+	}
+
+	constexpr Vector3 Matrix::GetAxisY() const
+	{
+		return data[1];
+	}
+
+	constexpr Vector3 Matrix::GetAxisZ() const
+	{
+		return data[2];
+	}
+
+	constexpr Vector3 Matrix::GetTranslation() const
+	{
+		return data[3];
+	}
+
+	constexpr Matrix Matrix::CreateTranslation(float x, float y, float z)
+	{
+		return { Vector3::UnitX, Vector3::UnitY, Vector3::UnitZ, Vector3{x,y,z} };
+	}
+
+	constexpr Matrix Matrix::CreateTranslation(const Vector3& t)
+	{
+		return { Vector3::UnitX, Vector3::UnitY, Vector3::UnitZ, t };
+	}
+
+	inline Matrix Matrix::CreateRotationX(float pitch)
+	{
+		const float cosine = float(cos(pitch));
+		const float sine = float(sin(pitch));
+		return { Vector3{1, 0, 0},  Vector3{0,cosine,-sine},  Vector3{0, sine, cosine},  Vector3{0, 0, 0}};
+	}
+
+	inline Matrix Matrix::CreateRotationY(float yaw)
+	{
+		const float cosine = float(cos(yaw));
+		const float sine = float(sin(yaw));
+		return { Vector3{cosine, 0, -sine},  Vector3{0,1,0},  Vector3{sine, 0, cosine},  Vector3{0, 0, 0} };
+	}
+
+	inline Matrix Matrix::CreateRotationZ(float roll)
+	{
+		const float cosine = float(cos(roll));
+		const float sine = float(sin(roll));
+		return { Vector3{cosine, sine, 0},  Vector3{-sine, cosine, 0},  Vector3{0, 0, 1},  Vector3{0, 0, 0} };
+	}
+
+	inline Matrix Matrix::CreateRotation(const Vector3& r)
+	{
+		return { CreateRotationX(r.x) * CreateRotationY(r.y) * CreateRotationZ(r.z) };
+	}
+
+	inline Matrix Matrix::CreateRotation(float pitch, float yaw, float roll)
+	{
+		return CreateRotation({ pitch, yaw, roll });
+	}
+
+	constexpr Matrix Matrix::CreateScale(float sx, float sy, float sz)
+	{
+		return {Vector3{sx,0,0},Vector3{0,sy,0}, Vector3{0,0,sz}, Vector3{0,0,1} };
+	}
+
+	constexpr Matrix Matrix::CreateScale(const Vector3& s)
+	{
+		return CreateScale(s[0], s[1], s[2]);
+	}
+
+	constexpr Vector4 Matrix::MultiplyRow(const Vector4& r, const Matrix& m)
+	{
+		return m.data[0] * r.x + m.data[1] * r.y + m.data[2] * r.z + m.data[3] * r.w;
+	}
+
+#pragma region Operator Overloads
+	constexpr Vector4& Matrix::operator[](int index)
+	{
+		assert(index <= 3 && index >= 0);
+		return data[index];
+	}
+
+	constexpr Vector4 Matrix::operator[](int index) const
+	{
+		assert(index <= 3 && index >= 0);
+		return data[index];
+	}
+
+	constexpr Matrix Matrix::operator*(const Matrix& m) const
+	{
+		return { MultiplyRow(data[0], m), MultiplyRow(data[1], m), MultiplyRow(data[2], m), MultiplyRow(data[3], m) };
+	}
+
+	constexpr bool Matrix::operator==(const Matrix& m) const
+	{
+		for (int r{ 0 }; r < 4; ++r)
+		{
+			if (data[r].x != m.data[r].x || data[r].y != m.data[r].y || data[r].z != m.data[r].z || data[r].w != m.data[r].w)
+				return false;
+		}
+		return true;
+	}
+
+	constexpr const Matrix& Matrix::operator*=(const Matrix& m)
+	{
+		*this = *this * m;
+		return *this;
+	}
+#pragma endregion
+}
@@ -0,0 +1,494 @@
+#include "RayPacket.h"
+
+#include "Utils.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define RAY_PACKET_X86
+#include <immintrin.h>
+#endif
+
+namespace dae
+{
+	namespace PacketUtils
+	{
+#if defined(RAY_PACKET_X86)
+		namespace
+		{
+			uint32_t GetGroupMask(uint32_t laneMask, uint32_t group)
+			{
+				return (laneMask >> (group * RayPacket::GroupSize)) & 0xF;
+			}
+
+			//all bits set for the lanes that are not in the group mask
+			__m128 GetInactiveLanes(uint32_t groupMask)
+			{
+				const __m128i laneBits{ _mm_and_si128(_mm_set1_epi32(static_cast<int>(groupMask)), _mm_setr_epi32(1, 2, 4, 8)) };
+				return _mm_castsi128_ps(_mm_cmpeq_epi32(laneBits, _mm_setzero_si128()));
+			}
+
+			//Both operands keep the order of std::min/std::max so the NaN cases come out the same as in the single ray slab test
+			__m128 Min(const __m128& a, const __m128& b) { return _mm_min_ps(b, a); }
+			__m128 Max(const __m128& a, const __m128& b) { return _mm_max_ps(b, a); }
+
+			__m128 Select(const __m128& mask, const __m128& ifTrue, const __m128& ifFalse)
+			{
+				return _mm_or_ps(_mm_and_ps(mask, ifTrue), _mm_andnot_ps(mask, ifFalse));
+			}
+
+			/**
+			 * \brief Packet version of GeometryUtils::SlabTest_BVHNode
+			 * \param laneMask lanes to test
+			 * \param entryDistance set to the smallest entry distance of the lanes that hit
+			 * \return mask of the lanes that enter the node before their max distance
+			 */
+			uint32_t SlabTest_BVHNode(const BVHNode& node, const RayPacket& packet, const float* maxDistances, uint32_t laneMask, float& entryDistance)
+			{
+				const Vector3 toMin{ node.minAABB - packet.origin };
+				const Vector3 toMax{ node.maxAABB - packet.origin };
+				const __m128 minX{ _mm_set1_ps(toMin.x) }, minY{ _mm_set1_ps(toMin.y) }, minZ{ _mm_set1_ps(toMin.z) };
+				const __m128 maxX{ _mm_set1_ps(toMax.x) }, maxY{ _mm_set1_ps(toMax.y) }, maxZ{ _mm_set1_ps(toMax.z) };
+				const __m128 zero{ _mm_setzero_ps() }, noHit{ _mm_set1_ps(FLT_MAX) };
+
+				__m128 closestEntry{ noHit };
+				uint32_t hitMask{};
+				for (uint32_t group{}; group < RayPacket::GroupCount; ++group)
+				{
+					const uint32_t groupMask{ GetGroupMask(laneMask, group) };
+					if (groupMask == 0) continue;
+
+					const uint32_t i{ group * RayPacket::GroupSize };
+					const __m128 inverseX{ _mm_load_ps(&packet.inverseDirectionX[i]) };
+					const __m128 inverseY{ _mm_load_ps(&packet.inverseDirectionY[i]) };
+					const __m128 inverseZ{ _mm_load_ps(&packet.inverseDirectionZ[i]) };
+
+					const __m128 tx1{ _mm_mul_ps(minX, inverseX) }, tx2{ _mm_mul_ps(maxX, inverseX) };
+					__m128 tmin{ Min(tx1, tx2) };
+					__m128 tmax{ Max(tx1, tx2) };
+
+					const __m128 ty1{ _mm_mul_ps(minY, inverseY) }, ty2{ _mm_mul_ps(maxY, inverseY) };
+					tmin = Max(tmin, Min(ty1, ty2));
+					tmax = Min(tmax, Max(ty1, ty2));
+
+					const __m128 tz1{ _mm_mul_ps(minZ, inverseZ) }, tz2{ _mm_mul_ps(maxZ, inverseZ) };
+					tmin = Max(tmin, Min(tz1, tz2));
+					tmax = Min(tmax, Max(tz1, tz2));
+
+					const __m128 hit{ _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(tmax, tmin), _mm_cmpgt_ps(tmax, zero)), _mm_cmplt_ps(tmin, _mm_load_ps(&maxDistances[i]))) };
+					const uint32_t groupHits{ static_cast<uint32_t>(_mm_movemask_ps(hit)) & groupMask };
+					if (groupHits == 0) continue;
+
+					hitMask |= groupHits << i;
+					closestEntry = _mm_min_ps(closestEntry, Select(_mm_andnot_ps(GetInactiveLanes(groupHits), hit), tmin, noHit));
+				}
+
+				alignas(16) float entries[RayPacket::GroupSize];
+				_mm_store_ps(entries, closestEntry);
+				entryDistance = std::min(std::min(entries[0], entries[1]), std::min(entries[2], entries[3]));
+				return hitMask;
+			}
+
+			/**
+			 * \brief Packet version of GeometryUtils::TraverseBVH, walks the tree once for all rays of the packet
+			 * \param maxDistances per lane, the callback lowers them when it finds closer hits
+			 * \param leafCallback void(const BVHNode& leaf, uint32_t laneMask), laneMask holds the lanes that reach the leaf
+			 */
+			template<typename LeafCallback>
+			void TraverseBVH(const std::vector<BVHNode>& nodes, const RayPacket& packet, const float* maxDistances, LeafCallback&& leafCallback)
+			{
+				if (nodes.empty()) return;
+
+				float entryDistance{};
+				uint32_t laneMask{ SlabTest_BVHNode(nodes[0], packet, maxDistances, packet.activeMask, entryDistance) };
+				if (laneMask == 0) return;
+
+				struct StackEntry
+				{
+					uint32_t nodeIndex;
+					uint32_t laneMask;
+				};
+				StackEntry stack[BVH::MaxDepth]{};
+				uint32_t stackSize{};
+				uint32_t nodeIndex{};
+
+				//pops the next node that still has lanes entering it, the closest hits may have moved since it was pushed
+				const auto popNode{ [&]()
+					{
+						while (stackSize > 0)
+						{
+							const StackEntry& entry{ stack[--stackSize] };
+							float distance{};
+							laneMask = SlabTest_BVHNode(nodes[entry.nodeIndex], packet, maxDistances, entry.laneMask, distance);
+							if (laneMask == 0) continue;
+
+							nodeIndex = entry.nodeIndex;
+							return true;
+						}
+						return false;
+					} };
+
+				while (true)
+				{
+					++GeometryUtils::g_VisitedNodeCount;
+					const BVHNode& node{ nodes[nodeIndex] };
+					if (node.IsLeaf())
+					{
+						leafCallback(node, laneMask);
+						if (!popNode()) return;
+						continue;
+					}
+
+					//visit the child the packet reaches first, ordered by the closest entry of any of its rays
+					uint32_t nearChild{ node.leftFirst };
+					uint32_t farChild{ node.leftFirst + 1 };
+					float nearDistance{}, farDistance{};
+					uint32_t nearMask{ SlabTest_BVHNode(nodes[nearChild], packet, maxDistances, laneMask, nearDistance) };
+					uint32_t farMask{ SlabTest_BVHNode(nodes[farChild], packet, maxDistances, laneMask, farDistance) };
+					if (nearDistance > farDistance)
+					{
+						std::swap(nearDistance, farDistance);
+						std::swap(nearChild, farChild);
+						std::swap(nearMask, farMask);
+					}
+
+					if (nearMask == 0)
+					{
+						if (!popNode()) return;
+						continue;
+					}
+
+					nodeIndex = nearChild;
+					laneMask = nearMask;
+					if (farMask != 0) stack[stackSize++] = { farChild, farMask };
+				}
+			}
+
+			//Packet version of the Moller-Trumbore kernels, one triangle at a time against 4 rays with the same origin
+			void IntersectLeaf(const TriangleSoA& triangles, const BVHNode& leaf, uint32_t laneMask, TriangleCullMode cullMode, const RayPacket& packet, float* closestT, int32_t* closestTriangle, uint32_t& hitMask)
+			{
+				const __m128 zero{ _mm_setzero_ps() }, one{ _mm_set1_ps(1.f) };
+				const __m128 epsilon{ _mm_set1_ps(FLT_EPSILON) }, negativeEpsilon{ _mm_set1_ps(-FLT_EPSILON) };
+				const __m128 rayMin{ _mm_set1_ps(packet.min) }, rayMax{ _mm_set1_ps(packet.max) };
+				const uint32_t end{ leaf.leftFirst + leaf.primitiveCount };
+
+				for (uint32_t group{}; group < RayPacket::GroupCount; ++group)
+				{
+					const uint32_t groupMask{ GetGroupMask(laneMask, group) };
+					if (groupMask == 0) continue;
+
+					const uint32_t lane{ group * RayPacket::GroupSize };
+					const __m128 dx{ _mm_load_ps(&packet.directionX[lane]) };
+					const __m128 dy{ _mm_load_ps(&packet.directionY[lane]) };
+					const __m128 dz{ _mm_load_ps(&packet.directionZ[lane]) };
+					const __m128 inactive{ GetInactiveLanes(groupMask) };
+
+					__m128 groupClosestT{ _mm_load_ps(&closestT[lane]) };
+					__m128i groupClosestTriangle{ _mm_load_si128(reinterpret_cast<const __m128i*>(&closestTriangle[lane])) };
+					uint32_t groupHits{};
+
+					for (uint32_t i{ leaf.leftFirst }; i < end; ++i)
+					{
+						const Vector3 edge1{ triangles.GetEdge1(i) };
+						const Vector3 edge2{ triangles.GetEdge2(i) };
+						const __m128 e1x{ _mm_set1_ps(edge1.x) }, e1y{ _mm_set1_ps(edge1.y) }, e1z{ _mm_set1_ps(edge1.z) };
+						const __m128 e2x{ _mm_set1_ps(edge2.x) }, e2y{ _mm_set1_ps(edge2.y) }, e2z{ _mm_set1_ps(edge2.z) };
+
+						//the shared origin makes s, q and Dot(edge2, q) the same for every ray
+						const Vector3 s{ packet.origin - triangles.GetV0(i) };
+						const Vector3 q{ Vector3::Cross(s, edge1) };
+						const __m128 edge2DotQ{ _mm_set1_ps(Vector3::Dot(edge2, q)) };
+
+						//h = Cross(direction, edge2), a = Dot(edge1, h)
+						const __m128 hx{ _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y)) };
+						const __m128 hy{ _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z)) };
+						const __m128 hz{ _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x)) };
+						const __m128 a{ _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, hx), _mm_mul_ps(e1y, hy)), _mm_mul_ps(e1z, hz)) };
+
+						__m128 reject{ inactive };
+						if (cullMode == TriangleCullMode::BackFaceCulling) reject = _mm_or_ps(reject, _mm_cmplt_ps(a, negativeEpsilon));
+						if (cullMode == TriangleCullMode::FrontFaceCulling) reject = _mm_or_ps(reject, _mm_cmpgt_ps(a, epsilon));
+
+						const __m128 f{ _mm_div_ps(one, a) };
+						const __m128 u{ _mm_mul_ps(f, _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(s.x), hx), _mm_mul_ps(_mm_set1_ps(s.y), hy)), _mm_mul_ps(_mm_set1_ps(s.z), hz))) };
+						reject = _mm_or_ps(reject, _mm_or_ps(_mm_cmplt_ps(u, zero), _mm_cmpgt_ps(u, one)));
+
+						const __m128 v{ _mm_mul_ps(f, _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, _mm_set1_ps(q.x)), _mm_mul_ps(dy, _mm_set1_ps(q.y))), _mm_mul_ps(dz, _mm_set1_ps(q.z)))) };
+						reject = _mm_or_ps(reject, _mm_or_ps(_mm_cmplt_ps(v, zero), _mm_cmpgt_ps(_mm_add_ps(u, v), one)));
+
+						const __m128 t{ _mm_mul_ps(f, edge2DotQ) };
+						reject = _mm_or_ps(reject, _mm_or_ps(_mm_cmpgt_ps(t, rayMax), _mm_cmplt_ps(t, rayMin)));
+
+						const __m128 accept{ _mm_andnot_ps(reject, _mm_cmplt_ps(t, groupClosestT)) };
+						const int acceptMask{ _mm_movemask_ps(accept) };
+						if (acceptMask == 0) continue;
+
+						groupClosestT = Select(accept, t, groupClosestT);
+						groupClosestTriangle = _mm_castps_si128(Select(accept, _mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(i))), _mm_castsi128_ps(groupClosestTriangle)));
+						groupHits |= static_cast<uint32_t>(acceptMask);
+					}
+
+					_mm_store_ps(&closestT[lane], groupClosestT);
+					_mm_store_si128(reinterpret_cast<__m128i*>(&closestTriangle[lane]), groupClosestTriangle);
+					hitMask |= groupHits << lane;
+				}
+			}
+
+			//object space packet, as in the single ray test the directions are left unnormalized
+			RayPacket GetObjectSpacePacket(const TriangleMesh& mesh, const RayPacket& packet, uint32_t laneMask)
+			{
+				RayPacket objectPacket{};
+				objectPacket.origin = mesh.inverseWorldTransform.TransformPoint(packet.origin);
+				objectPacket.min = packet.min;
+				objectPacket.max = packet.max;
+				for (uint32_t lane{}; lane < RayPacket::Size; ++lane)
+				{
+					if ((laneMask >> lane) & 1)
+						objectPacket.SetDirection(lane, mesh.inverseWorldTransform.TransformVector({ packet.directionX[lane], packet.directionY[lane], packet.directionZ[lane] }));
+				}
+				return objectPacket;
+			}
+
+			void HitTest_TriangleMesh(const TriangleMesh& mesh, const RayPacket& packet, uint32_t laneMask, HitRecord* hitRecords, float* maxDistances)
+			{
+				const std::vector<BVHNode>& nodes{ mesh.bvh.GetNodes() };
+				if (nodes.empty()) return;
+
+				const RayPacket objectPacket{ GetObjectSpacePacket(mesh, packet, laneMask) };
+
+				//only hits closer than what the lanes already found are of interest
+				alignas(16) float closestT[RayPacket::Size];
+				alignas(16) int32_t closestTriangle[RayPacket::Size]{};
+				std::copy(maxDistances, maxDistances + RayPacket::Size, closestT);
+				uint32_t hitMask{};
+
+				const TriangleCullMode cullMode{ GeometryUtils::GetObjectSpaceCullMode(mesh) };
+				TraverseBVH(nodes, objectPacket, closestT, [&](const BVHNode& leaf, uint32_t leafLaneMask)
+					{
+						IntersectLeaf(mesh.triangleData, leaf, leafLaneMask, cullMode, objectPacket, closestT, closestTriangle, hitMask);
+					});
+
+				for (uint32_t lane{}; lane < RayPacket::Size; ++lane)
+				{
+					if (!((hitMask >> lane) & 1)) continue;
+
+					GeometryUtils::FillTriangleMeshHitRecord(mesh, packet.GetRay(lane), closestT[lane], closestTriangle[lane], hitRecords[lane]);
+					maxDistances[lane] = closestT[lane];
+				}
+			}
+
+			//Any-hit version of HitTest_TriangleMesh, returns the lanes blocked before their max distance
+			uint32_t DoesHit_TriangleMesh(const TriangleMesh& mesh, const RayPacket& packet, uint32_t laneMask, const float* maxDistances, uint32_t& occludingTriangle)
+			{
+				const std::vector<BVHNode>& nodes{ mesh.bvh.GetNodes() };
+				if (nodes.empty()) return 0;
+
+				const RayPacket objectPacket{ GetObjectSpacePacket(mesh, packet, laneMask) };
+				alignas(16) float closestT[RayPacket::Size];
+				alignas(16) int32_t closestTriangle[RayPacket::Size]{};
+				std::copy(maxDistances, maxDistances + RayPacket::Size, closestT);
+				uint32_t blockedMask{};
+
+				const TriangleCullMode cullMode{ GeometryUtils::GetObjectSpaceCullMode(mesh) };
+				TraverseBVH(nodes, objectPacket, closestT, [&](const BVHNode& leaf, uint32_t leafLaneMask)
+					{
+						uint32_t hitMask{};
+						IntersectLeaf(mesh.triangleData, leaf, leafLaneMask, cullMode, objectPacket, closestT, closestTriangle, hitMask);
+						for (uint32_t lane{}; lane < RayPacket::Size; ++lane)
+						{
+							if (!((hitMask >> lane) & 1)) continue;
+
+							//a blocked lane is done, no node can be entered before -FLT_MAX
+							occludingTriangle = uint32_t(closestTriangle[lane]);
+							closestT[lane] = -FLT_MAX;
+						}
+						blockedMask |= hitMask;
+					});
+				return blockedMask;
+			}
+		}
+
+		void HitTest_Sphere(const Sphere& sphere, const RayPacket& packet, HitRecord* hitRecords)
+		{
+			const Vector3 toOrigin{ packet.origin - sphere.origin };
+			const __m128 lx{ _mm_set1_ps(toOrigin.x) }, ly{ _mm_set1_ps(toOrigin.y) }, lz{ _mm_set1_ps(toOrigin.z) };
+			const __m128 c{ _mm_set1_ps(Vector3::Dot(toOrigin, toOrigin) - (sphere.radius * sphere.radius)) };
+			const __m128 zero{ _mm_setzero_ps() };
+
+			for (uint32_t group{}; group < RayPacket::GroupCount; ++group)
+			{
+				const uint32_t groupMask{ GetGroupMask(packet.activeMask, group) };
+				if (groupMask == 0) continue;
+
+				//only the discriminant is done for all lanes, whether the sqrt of the single ray test rounds through double
+				//depends on the compiler, so the few lanes that pass redo that test to get the exact same distance
+				const uint32_t lane{ group * RayPacket::GroupSize };
+				const __m128 b{ _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_load_ps(&packet.directionX[lane]), lx), _mm_mul_ps(_mm_load_ps(&packet.directionY[lane]), ly)), _mm_mul_ps(_mm_load_ps(&packet.directionZ[lane]), lz)) };
+				const __m128 d{ _mm_sub_ps(_mm_mul_ps(b, b), c) };
+				const int candidateMask{ _mm_movemask_ps(_mm_andnot_ps(GetInactiveLanes(groupMask), _mm_cmpgt_ps(d, zero))) };
+				if (candidateMask == 0) continue;
+
+				for (uint32_t i{}; i < RayPacket::GroupSize; ++i)
+				{
+					HitRecord tempHit{};
+					if ((candidateMask >> i) & 1 && GeometryUtils::HitTest_Sphere(sphere, packet.GetRay(lane + i), tempHit) && tempHit.t < hitRecords[lane + i].t)
+						hitRecords[lane + i] = tempHit;
+				}
+			}
+		}
+
+		void HitTest_Plane(const Plane& plane, const RayPacket& packet, HitRecord* hitRecords)
+		{
+			const __m128 numerator{ _mm_set1_ps(Vector3::Dot((plane.origin - packet.origin), plane.normal)) };
+			const __m128 nx{ _mm_set1_ps(plane.normal.x) }, ny{ _mm_set1_ps(plane.normal.y) }, nz{ _mm_set1_ps(plane.normal.z) };
+			const __m128 rayMin{ _mm_set1_ps(packet.min) }, rayMax{ _mm_set1_ps(packet.max) };
+
+			for (uint32_t group{}; group < RayPacket::GroupCount; ++group)
+			{
+				const uint32_t groupMask{ GetGroupMask(packet.activeMask, group) };
+				if (groupMask == 0) continue;
+
+				const uint32_t lane{ group * RayPacket::GroupSize };
+				const __m128 denominator{ _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_load_ps(&packet.directionX[lane]), nx), _mm_mul_ps(_mm_load_ps(&packet.directionY[lane]), ny)), _mm_mul_ps(_mm_load_ps(&packet.directionZ[lane]), nz)) };
+				const __m128 t{ _mm_div_ps(numerator, denominator) };
+
+				const __m128 closestT{ _mm_setr_ps(hitRecords[lane].t, hitRecords[lane + 1].t, hitRecords[lane + 2].t, hitRecords[lane + 3].t) };
+				const __m128 hit{ _mm_and_ps(_mm_and_ps(_mm_cmplt_ps(t, rayMax), _mm_cmpgt_ps(t, rayMin)), _mm_cmplt_ps(t, closestT)) };
+				const int acceptMask{ _mm_movemask_ps(_mm_andnot_ps(GetInactiveLanes(groupMask), hit)) };
+				if (acceptMask == 0) continue;
+
+				alignas(16) float distances[RayPacket::GroupSize];
+				_mm_store_ps(distances, t);
+				for (uint32_t i{}; i < RayPacket::GroupSize; ++i)
+				{
+					if (!((acceptMask >> i) & 1)) continue;
+
+					const Ray ray{ packet.GetRay(lane + i) };
+					HitRecord& hitRecord{ hitRecords[lane + i] };
+					hitRecord.t = distances[i];
+					hitRecord.origin = ray.origin + ray.direction * hitRecord.t;
+					hitRecord.normal = plane.normal;
+					hitRecord.didHit = true;
+					hitRecord.materialIndex = plane.materialIndex;
+				}
+			}
+		}
+
+		void HitTest_TriangleMeshes(const BVH& topLevelBVH, const std::vector<TriangleMesh>& meshes, const RayPacket& packet, HitRecord* hitRecords)
+		{
+			alignas(16) float maxDistances[RayPacket::Size]{};
+			for (uint32_t lane{}; lane < RayPacket::Size; ++lane) maxDistances[lane] = std::min(packet.max, hitRecords[lane].t);
+
+			const std::vector<uint32_t>& instanceIndices{ topLevelBVH.GetPrimitiveIndices() };
+			TraverseBVH(topLevelBVH.GetNodes(), packet, maxDistances, [&](const BVHNode& leaf, uint32_t laneMask)
+				{
+					for (uint32_t i{}; i < leaf.primitiveCount; ++i)
+						HitTest_TriangleMesh(meshes[instanceIndices[leaf.leftFirst + i]], packet, laneMask, hitRecords, maxDistances);
+				});
+		}
+
+		uint32_t DoesHit_TriangleMeshes(const BVH& topLevelBVH, const std::vector<TriangleMesh>& meshes, const RayPacket& packet, const float* maxDistances, uint32_t& occludingMesh, uint32_t& occludingTriangle)
+		{
+			alignas(16) float distances[RayPacket::Size]{};
+			std::copy(maxDistances, maxDistances + RayPacket::Size, distances);
+			uint32_t blockedMask{};
+
+			const std::vector<uint32_t>& instanceIndices{ topLevelBVH.GetPrimitiveIndices() };
+			TraverseBVH(topLevelBVH.GetNodes(), packet, distances, [&](const BVHNode& leaf, uint32_t laneMask)
+				{
+					for (uint32_t i{}; i < leaf.primitiveCount && (laneMask & ~blockedMask) != 0; ++i)
+					{
+						const uint32_t meshIndex{ instanceIndices[leaf.leftFirst + i] };
+						const uint32_t meshBlockedMask{ DoesHit_TriangleMesh(meshes[meshIndex], packet, laneMask & ~blockedMask, maxDistances, occludingTriangle) };
+						if (meshBlockedMask == 0) continue;
+
+						occludingMesh = meshIndex;
+						blockedMask |= meshBlockedMask;
+						for (uint32_t lane{}; lane < RayPacket::Size; ++lane)
+						{
+							if ((meshBlockedMask >> lane) & 1) distances[lane] = -FLT_MAX;
+						}
+					}
+				});
+			return blockedMask;
+		}
+#else
+		//No SIMD packet path on this architecture, the lanes are traced one by one with the single ray tests
+
+		void HitTest_Sphere(const Sphere& sphere, const RayPacket& packet, HitRecord* hitRecords)
+		{
+			for (uint32_t lane{}; lane < RayPacket::Size; ++lane)
+			{
+				HitRecord tempHit{};
+				if (packet.IsActive(lane) && GeometryUtils::HitTest_Sphere(sphere, packet.GetRay(lane), tempHit) && tempHit.t < hitRecords[lane].t)
+					hitRecords[lane] = tempHit;
+			}
+		}
+
+		void HitTest_Plane(const Plane& plane, const RayPacket& packet, HitRecord* hitRecords)
+		{
+			for (uint32_t lane{}; lane < RayPacket::Size; ++lane)
+			{
+				HitRecord tempHit{};
+				if (packet.IsActive(lane) && GeometryUtils::HitTest_Plane(plane, packet.GetRay(lane), tempHit) && tempHit.t < hitRecords[lane].t)
+					hitRecords[lane] = tempHit;
+			}
+		}
+
+		void HitTest_TriangleMeshes(const BVH& topLevelBVH, const std::vector<TriangleMesh>& meshes, const RayPacket& packet, HitRecord* hitRecords)
+		{
+			const std::vector<uint32_t>& instanceIndices{ topLevelBVH.GetPrimitiveIndices() };
+			for (uint32_t lane{}; lane < RayPacket::Size; ++lane)
+			{
+				if (!packet.IsActive(lane)) continue;
+
+				const Ray ray{ packet.GetRay(lane) };
+				const Vector3 inverseDirection{ packet.inverseDirectionX[lane], packet.inverseDirectionY[lane], packet.inverseDirectionZ[lane] };
+				float maxDistance{ std::min(ray.max, hitRecords[lane].t) };
+
+				GeometryUtils::TraverseBVH(topLevelBVH.GetNodes(), ray, inverseDirection, maxDistance, [&](const BVHNode& leaf)
+					{
+						for (uint32_t i{}; i < leaf.primitiveCount; ++i)
+						{
+							HitRecord tempHit{};
+							if (GeometryUtils::HitTest_TriangleMesh(meshes[instanceIndices[leaf.leftFirst + i]], ray, tempHit) && tempHit.t < hitRecords[lane].t)
+							{
+								hitRecords[lane] = tempHit;
+								maxDistance = std::min(maxDistance, tempHit.t);
+							}
+						}
+						return false;
+					});
+			}
+		}
+
+		uint32_t DoesHit_TriangleMeshes(const BVH& topLevelBVH, const std::vector<TriangleMesh>& meshes, const RayPacket& packet, const float* maxDistances, uint32_t& occludingMesh, uint32_t& occludingTriangle)
+		{
+			const std::vector<uint32_t>& instanceIndices{ topLevelBVH.GetPrimitiveIndices() };
+			uint32_t blockedMask{};
+			for (uint32_t lane{}; lane < RayPacket::Size; ++lane)
+			{
+				if (!packet.IsActive(lane)) continue;
+
+				const Ray ray{ packet.origin, { packet.directionX[lane], packet.directionY[lane], packet.directionZ[lane] }, packet.min, maxDistances[lane] };
+				const Vector3 inverseDirection{ packet.inverseDirectionX[lane], packet.inverseDirectionY[lane], packet.inverseDirectionZ[lane] };
+				float maxDistance{ ray.max };
+
+				GeometryUtils::TraverseBVH(topLevelBVH.GetNodes(), ray, inverseDirection, maxDistance, [&](const BVHNode& leaf)
+					{
+						for (uint32_t i{}; i < leaf.primitiveCount; ++i)
+						{
+							const uint32_t meshIndex{ instanceIndices[leaf.leftFirst + i] };
+							if (GeometryUtils::DoesHit_TriangleMesh(meshes[meshIndex], ray, occludingTriangle))
+							{
+								occludingMesh = meshIndex;
+								blockedMask |= 1u << lane;
+								return true;
+							}
+						}
+						return false;
+					});
+			}
+			return blockedMask;
+		}
+#endif
+	}
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+#include "DataTypes.h"
+
+namespace dae
+{
+	//Bundle of coherent rays that share an origin (the primary rays of a 4x4 pixel tile).
+	//Lanes are grouped per 2x2 pixel quad, every group of GroupSize lanes is traced in one SIMD register
+	struct RayPacket
+	{
+		static constexpr uint32_t TileSize{ 4 };
+		static constexpr uint32_t Size{ TileSize * TileSize };
+		static constexpr uint32_t GroupSize{ 4 };
+		static constexpr uint32_t GroupCount{ Size / GroupSize };
+
+		Vector3 origin{};
+		alignas(16) float directionX[Size]{};
+		alignas(16) float directionY[Size]{};
+		alignas(16) float directionZ[Size]{};
+		alignas(16) float inverseDirectionX[Size]{};
+		alignas(16) float inverseDirectionY[Size]{};
+		alignas(16) float inverseDirectionZ[Size]{};
+
+		float min{ 0.0001f };
+		float max{ FLT_MAX };
+
+		uint32_t activeMask{}; //bit per lane, lanes outside the image are left inactive
+
+		//Pixel offset of a lane inside the tile
+		static uint32_t GetLaneX(uint32_t lane) { return (lane / GroupSize) % 2 * 2 + lane % 2; }
+		static uint32_t GetLaneY(uint32_t lane) { return (lane / GroupSize) / 2 * 2 + (lane % GroupSize) / 2; }
+
+		bool IsActive(uint32_t lane) const { return (activeMask >> lane) & 1; }
+		uint32_t GetActiveCount() const { return uint32_t(std::popcount(activeMask)); }
+
+		void SetDirection(uint32_t lane, const Vector3& direction)
+		{
+			directionX[lane] = direction.x;
+			directionY[lane] = direction.y;
+			directionZ[lane] = direction.z;
+			inverseDirectionX[lane] = 1.f / direction.x;
+			inverseDirectionY[lane] = 1.f / direction.y;
+			inverseDirectionZ[lane] = 1.f / direction.z;
+			activeMask |= 1u << lane;
+		}
+
+		Ray GetRay(uint32_t lane) const
+		{
+			return Ray{ origin, { directionX[lane], directionY[lane], directionZ[lane] }, min, max };
+		}
+
+		//Packet traversal pays off as long as the rays head the same way, rays pointing into different octants are traced one by one
+		bool IsCoherent() const
+		{
+			//bit 0: some ray points along the positive axis, bit 1: some ray points along the negative axis
+			uint32_t signsX{}, signsY{}, signsZ{};
+			for (uint32_t lane{}; lane < Size; ++lane)
+			{
+				if (!IsActive(lane)) continue;
+				signsX |= (directionX[lane] < 0.f ? 2u : 1u);
+				signsY |= (directionY[lane] < 0.f ? 2u : 1u);
+				signsZ |= (directionZ[lane] < 0.f ? 2u : 1u);
+			}
+			return signsX != 3 && signsY != 3 && signsZ != 3;
+		}
+	};
+
+	//Closest-hit tests for a whole packet, each lane's hit record is only replaced by a closer hit.
+	//Per lane the same arithmetic as the single ray tests in GeometryUtils is done, so the hits match them
+	//(only ties between equally distant triangles of different BVH leaves can resolve differently)
+	namespace PacketUtils
+	{
+		void HitTest_Sphere(const Sphere& sphere, const RayPacket& packet, HitRecord* hitRecords);
+		void HitTest_Plane(const Plane& plane, const RayPacket& packet, HitRecord* hitRecords);
+
+		/**
+		 * \brief Traces the packet through the top level BVH and the BVHs of the meshes it reaches
+		 * \param topLevelBVH hierarchy over the world bounds of the meshes
+		 * \param meshes the mesh instances the top level primitive indices refer to
+		 */
+		void HitTest_TriangleMeshes(const BVH& topLevelBVH, const std::vector<TriangleMesh>& meshes, const RayPacket& packet, HitRecord* hitRecords);
+
+		/**
+		 * \brief Any-hit version of HitTest_TriangleMeshes, a lane drops out of the traversal as soon as something blocks it
+		 * \param maxDistances per lane, only hits closer than this count
+		 * \param occludingMesh, occludingTriangle what blocked the last blocked lane, to seed the occluder cache
+		 * \return mask of the lanes that are blocked
+		 */
+		uint32_t DoesHit_TriangleMeshes(const BVH& topLevelBVH, const std::vector<TriangleMesh>& meshes, const RayPacket& packet, const float* maxDistances, uint32_t& occludingMesh, uint32_t& occludingTriangle);
+	}
+}
@@ -1,7 +1,3 @@
-//External includes
-#include "SDL.h"
-#include "SDL_surface.h"
-
 //Project includes
 #include "Renderer.h"
 #include "Math.h"
@@ -9,185 +5,1577 @@
 #include "Material.h"
 #include "Scene.h"
 #include "Utils.h"
+#include "RayPacket.h"
+#include "WavefrontQueues.h"
+#include "LightTree.h"
+#include "Console.h"
 
-#include <execution>
-#include<Windows.h>
-
-#ifdef max
-#undef max
-#endif
-
-#define PARALLEL_EXECUTION
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <fstream>
+#include <iostream>
 
 using namespace dae;
 
-Renderer::Renderer(SDL_Window* pWindow) :
-	m_pWindow(pWindow),
-	m_pBuffer(SDL_GetWindowSurface(pWindow))
+Renderer::Renderer(uint32_t width, uint32_t height) :
+	m_Width(int(width)),
+	m_Height(int(height)),
+	m_OutputWidth(int(width)),
+	m_OutputHeight(int(height)),
+	m_Pixels(size_t(width) * height, 0xFF000000),
+	m_SampleSums(size_t(width) * height),
+	m_LuminanceSums(size_t(width) * height),
+	m_LuminanceSquareSums(size_t(width) * height),
+	m_SampleCounts(size_t(width) * height),
+	m_PrimarySamples(size_t(width) * height),
+	m_ReprojectedSamples(size_t(width) * height),
+	m_IsPixelReused(size_t(width) * height),
+	m_IsPixelChanged(size_t(width) * height)
+{
+	m_pThreadPool = std::make_unique<ThreadPool>();
+}
+
+namespace
 {
-	//Initialize
-	SDL_GetWindowSize(pWindow, &m_Width, &m_Height);
-	m_pBufferPixels = static_cast<uint32_t*>(m_pBuffer->pixels);
+	//Radical inverse of index, the Halton sequence spreads the sample positions evenly over the pixel
+	float Halton(uint32_t index, uint32_t base)
+	{
+		float result{};
+		float fraction{ 1.f / base };
+		for (; index > 0; index /= base, fraction /= base)
+		{
+			result += fraction * (index % base);
+		}
+		return result;
+	}
+
+	//PCG output permutation, turns consecutive numbers into unrelated ones
+	uint32_t Hash(uint32_t value)
+	{
+		const uint32_t state{ value * 747796405u + 2891336453u };
+		const uint32_t word{ ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u };
+		return (word >> 22u) ^ word;
+	}
+
+	//Uniform number in [0, 1) from the top 24 bits of a hash
+	float GetRandom(uint32_t seed, uint32_t index)
+	{
+		return float(Hash(seed + index) >> 8) * (1.f / 16777216.f);
+	}
+
+	float GetLuminance(const ColorRGB& color)
+	{
+		return 0.2126f * color.r + 0.7152f * color.g + 0.0722f * color.b;
+	}
+
+	//Luminance the sample has clamped to what a screen shows, convergence and edges are judged on that. Raw radiance
+	//would keep an HDR highlight from ever settling
+	float GetDisplayLuminance(ColorRGB color)
+	{
+		color.MaxToOne();
+		return GetLuminance(color);
+	}
+
+	//4x4 ordered dither, every value appears once per 4x4 block so a refresh slice is spread evenly over the screen
+	uint32_t GetBayerIndex(uint32_t px, uint32_t py)
+	{
+		constexpr uint32_t bayer[4][4]{ { 0, 8, 2, 10 }, { 12, 4, 14, 6 }, { 3, 11, 1, 9 }, { 15, 7, 13, 5 } };
+		return bayer[py & 3][px & 3];
+	}
 }
 
-void Renderer::Render(Scene* pScene) const
+void Renderer::Render(Scene* pScene)
 {
 	Camera& camera = pScene->GetCamera();
-	std::vector<dae::Material*> materials = pScene->GetMaterials();
+	const std::vector<dae::MaterialData>& materials = pScene->GetMaterialData();
 	std::vector<dae::Light> lights = pScene->GetLights();
 
-	float aspectRatio{ float(m_Width) / float(m_Height) };
+	//how far every light reaches this frame, blocks of pixels cull their light lists against it
+	m_LightOrigins.resize(lights.size());
+	m_LightRadiiSqr.resize(lights.size());
+	m_AllLights.resize(lights.size());
+	for (uint32_t i{}; i < lights.size(); ++i)
+	{
+		m_LightOrigins[i] = lights[i].origin;
+		m_LightRadiiSqr[i] = LightUtils::GetInfluenceRadiusSqr(lights[i], m_LightCutoff);
+		m_AllLights[i] = i;
+	}
+
+	m_pShadePixel = GetShadePixelFunction(m_CurrentLightingMode, m_ShadowsEnabled, m_FastMathEnabled);
+	m_pShadeHits = GetShadeHitsFunction(m_CurrentLightingMode, m_FastMathEnabled);
+
+	//the wavefront shades the materials of one type after each other
+	m_MaterialOrder.resize(materials.size());
+	for (uint32_t i{}; i < materials.size(); ++i) m_MaterialOrder[i] = i;
+	std::stable_sort(m_MaterialOrder.begin(), m_MaterialOrder.end(), [&](uint32_t a, uint32_t b) { return materials[a].type < materials[b].type; });
+
+	//the output's, a scaled down image rounds its sides separately
+	float aspectRatio{ float(m_OutputWidth) / float(m_OutputHeight) };
 
 	Matrix cameraToWorld{ camera.CalculateCameraToWorld() };
 
-#if defined(PARALLEL_EXECUTION)
-	// parallel logic
-	uint32_t amountOfPixels{ uint32_t(m_Width * m_Height) };
-	std::vector<uint32_t> pixelIndices{};
+	//any change makes the old samples describe a different image
+	const bool hasSceneChanged{ pScene != m_pLastScene || pScene->GetVersion() != m_LastSceneVersion };
+	const bool hasCameraMoved{ !(cameraToWorld == m_LastCameraToWorld) || camera.fovValue != m_LastFov };
+	const bool hasChanged{ hasSceneChanged || hasCameraMoved };
+	m_HasCameraMoved = hasCameraMoved;
+
+	//moved geometry only spoils last frame's hits where they could see it or its shadow, as long as the scene can say where it moved.
+	//Shadow volumes are built from light origins, a directional light has none, so it redraws everything
+	const bool hasDirectionalLight{ std::any_of(lights.begin(), lights.end(), [](const Light& light) { return light.type == LightType::Directional; }) };
+	const bool canBoundChanges{ m_DirtyRegionsEnabled && !hasDirectionalLight && pScene == m_pLastScene && pScene->GetChangedBoundsBaseVersion() == m_LastSceneVersion };
+	const bool canReuse{ m_ArePrimarySamplesValid && (!hasSceneChanged || canBoundChanges) };
+	m_IsReprojecting = m_ReprojectionEnabled && canReuse && hasCameraMoved;
+	m_IsKeepingUnchangedPixels = canReuse && hasSceneChanged && !hasCameraMoved;
+	m_HasMovedGeometry = hasSceneChanged && (m_IsReprojecting || m_IsKeepingUnchangedPixels);
+	if (m_IsReprojecting) ReprojectPrimarySamples(cameraToWorld, camera.origin, camera.fovValue, aspectRatio);
+	if (m_HasMovedGeometry) BuildChangeRegions(pScene, lights, cameraToWorld, camera.origin, camera.fovValue, aspectRatio);
+
+	if (hasChanged || !m_AccumulationEnabled)
+	{
+		m_pLastScene = pScene;
+		m_LastSceneVersion = pScene->GetVersion();
+		m_LastCameraToWorld = cameraToWorld;
+		m_LastFov = camera.fovValue;
+		m_SampleIndex = 0;
+	}
+
+	m_UnconvergedPixelCount = 0;
+	m_EdgePixelCount = 0;
+	m_ReusedPixelCount = 0;
+	m_ShadowRayCount = 0;
+	m_ShadowNodeCount = 0;
+
+	const uint32_t tileCountX{ (m_Width + m_TileSize - 1) / m_TileSize };
+	const uint32_t tileCountY{ (m_Height + m_TileSize - 1) / m_TileSize };
+	const bool refineEdges{ m_SampleIndex == 0 && m_EdgeAntiAliasingEnabled && m_EdgeSampleCount > 0 };
+
+	//a pixel is judged by its neighbours as well, so all of them have to be marked first
+	if (m_HasMovedGeometry)
+	{
+		m_pThreadPool->ParallelFor(tileCountX * tileCountY, [&](uint32_t tileIndex) {
+			MarkChangedPixels(tileIndex, tileCountX, lights);
+			});
+	}
 
-	pixelIndices.reserve(amountOfPixels);
-	for (uint32_t idx{}; idx < amountOfPixels; ++idx) pixelIndices.emplace_back(idx);
+	m_pThreadPool->ParallelFor(tileCountX * tileCountY, [&](uint32_t tileIndex) {
+		if (m_IsReprojecting) ApplyReprojectedSamples(tileIndex, tileCountX);
+		else if (m_IsKeepingUnchangedPixels) KeepUnchangedPixels(tileIndex, tileCountX);
+		RenderTile(pScene, tileIndex, tileCountX, camera.fovValue, aspectRatio, cameraToWorld, camera.origin, materials, lights);
+		if (!refineEdges) CountUnconvergedPixels(tileIndex, tileCountX);
+		});
+
+	//edge pixels compare against neighbours from other tiles, so the first pass has to be complete
+	if (refineEdges)
 	{
-		std::for_each(std::execution::par, pixelIndices.begin(), pixelIndices.end(), [&](int i) {
-			RenderPixel(pScene, i, camera.fovValue, aspectRatio, cameraToWorld, camera.origin, materials, lights);
+		m_pThreadPool->ParallelFor(tileCountX * tileCountY, [&](uint32_t tileIndex) {
+			RefineEdges(pScene, tileIndex, tileCountX, camera.fovValue, aspectRatio, cameraToWorld, camera.origin, materials, lights);
+			CountUnconvergedPixels(tileIndex, tileCountX);
 			});
 	}
 
-#else
-	// Synchronous logic (no trheading)
-	uint32_t amountOfPixels{ uint32_t(m_Width * m_Height) };
-	for (uint32_t pixelIndex{}; pixelIndex < amountOfPixels; ++pixelIndex)
+	//the tiles only wrote radiance, the 8 bit image is made from it in one pass over the whole frame
+	m_pThreadPool->ParallelFor(m_Height, [this](uint32_t y) {
+		ResolveRow(y);
+		});
+
+	if (IsUpscaling())
 	{
-		RenderPixel(pScene, pixelIndex, camera.fovValue, aspectRatio, cameraToWorld, camera.origin);
+		m_pThreadPool->ParallelFor(m_OutputHeight, [this](uint32_t y) {
+			UpscaleRow(y);
+			});
 	}
 
-#endif
-	//@END
-	//Update SDL Surface
-	SDL_UpdateWindowSurface(m_pWindow);
+	if (m_SampleIndex == 0) m_ArePrimarySamplesValid = m_ReprojectionEnabled || m_DirtyRegionsEnabled;
+	++m_SampleIndex;
+	++m_FrameIndex;
 }
 
-void dae::Renderer::RenderPixel(Scene* pScene, uint32_t pixelIndex, float fov, float aspectRatio, const Matrix cameraToWorld, const Vector3 camerOrigin, std::vector<dae::Material*>& materials, std::vector<dae::Light>& lights) const
+void Renderer::SetRenderScale(float scale)
 {
-	const uint32_t px{ pixelIndex % m_Width }, py{ pixelIndex / m_Width };
+	m_RenderScale = std::clamp(scale, MinRenderScale, 1.f);
+	const int width{ std::max(int(m_OutputWidth * m_RenderScale + .5f), 1) };
+	const int height{ std::max(int(m_OutputHeight * m_RenderScale + .5f), 1) };
+	if (width == m_Width && height == m_Height) return;
 
-	float rx{ px + 0.5f }, ry{ py + 0.5f };
-	float cx{ (2 * (rx / float(m_Width)) - 1) * aspectRatio * fov };
-	float cy{ (1 - (2 * (ry / float(m_Height)))) * fov };
+	m_Width = width;
+	m_Height = height;
 
+	//shrinking keeps the capacity, switching back and forth does not allocate
+	const size_t pixelCount{ size_t(width) * height };
+	m_Pixels.resize(pixelCount);
+	m_SampleSums.resize(pixelCount);
+	m_LuminanceSums.resize(pixelCount);
+	m_LuminanceSquareSums.resize(pixelCount);
+	m_SampleCounts.resize(pixelCount);
+	m_PrimarySamples.resize(pixelCount);
+	m_ReprojectedSamples.resize(pixelCount);
+	m_IsPixelReused.resize(pixelCount);
+	m_IsPixelChanged.resize(pixelCount);
+	m_OutputPixels.resize(size_t(m_OutputWidth) * m_OutputHeight);
 
-	Ray viewRay{ camerOrigin };
-	Vector3 rayDirection{cx, cy, 1 };
+	//the samples no longer line up with the pixels
+	m_ArePrimarySamplesValid = false;
+	ResetAccumulation();
+}
 
-	viewRay.direction = cameraToWorld.TransformVector(rayDirection.Normalized());
-	Vector3 v{ viewRay.direction * -1 };
+void Renderer::SwapPixels(std::vector<uint32_t>& pixels)
+{
+	//ResolveRow and UpscaleRow overwrite every pixel each frame, what the swapped in storage held does not matter
+	std::vector<uint32_t>& frame{ IsUpscaling() ? m_OutputPixels : m_Pixels };
+	const size_t pixelCount{ frame.size() };
+	frame.swap(pixels);
+	frame.resize(pixelCount);
+}
+
+void Renderer::ResolveRow(uint32_t y) const
+{
+	const size_t first{ size_t(y) * m_Width };
+	m_Tonemapper.Resolve(m_SampleSums.data() + first, m_SampleCounts.data() + first, m_Pixels.data() + first, uint32_t(m_Width));
+}
+
+void Renderer::UpscaleRow(uint32_t y) const
+{
+	//bilinear, the output pixel centers are mapped onto the traced image
+	const float scaleX{ float(m_Width) / m_OutputWidth }, scaleY{ float(m_Height) / m_OutputHeight };
+	const float sourceY{ std::clamp((y + .5f) * scaleY - .5f, 0.f, float(m_Height - 1)) };
+	const uint32_t y0{ uint32_t(sourceY) }, y1{ std::min(y0 + 1, uint32_t(m_Height) - 1) };
+	const float weightY{ sourceY - y0 };
+
+	const uint32_t* pTopRow{ m_Pixels.data() + size_t(y0) * m_Width };
+	const uint32_t* pBottomRow{ m_Pixels.data() + size_t(y1) * m_Width };
+	uint32_t* pOutputRow{ m_OutputPixels.data() + size_t(y) * m_OutputWidth };
+	for (int x{}; x < m_OutputWidth; ++x)
+	{
+		const float sourceX{ std::clamp((x + .5f) * scaleX - .5f, 0.f, float(m_Width - 1)) };
+		const uint32_t x0{ uint32_t(sourceX) }, x1{ std::min(x0 + 1, uint32_t(m_Width) - 1) };
+		const float weightX{ sourceX - x0 };
+
+		uint32_t color{ 0xFF000000 };
+		for (uint32_t shift{}; shift < 24; shift += 8)
+		{
+			const auto channel{ [shift](uint32_t pixel) { return float((pixel >> shift) & 0xFF); } };
+			const float top{ channel(pTopRow[x0]) + (channel(pTopRow[x1]) - channel(pTopRow[x0])) * weightX };
+			const float bottom{ channel(pBottomRow[x0]) + (channel(pBottomRow[x1]) - channel(pBottomRow[x0])) * weightX };
+			color |= uint32_t(top + (bottom - top) * weightY + .5f) << shift;
+		}
+		pOutputRow[x] = color;
+	}
+}
+
+void dae::Renderer::RenderPixel(Scene* pScene, uint32_t pixelIndex, float fov, float aspectRatio, const Matrix cameraToWorld, const Vector3 camerOrigin, const std::vector<dae::MaterialData>& materials, std::vector<dae::Light>& lights, std::vector<Occluder>& occluders) const
+{
+	if (!NeedsSample(pixelIndex)) return;
+	const uint32_t px{ pixelIndex % m_Width }, py{ pixelIndex / m_Width };
+
+	float offsetX{}, offsetY{};
+	GetSampleOffset(pixelIndex, offsetX, offsetY);
+
+	Ray viewRay{ camerOrigin };
+	viewRay.direction = GetViewDirection(px + offsetX, py + offsetY, fov, aspectRatio, cameraToWorld);
 
 	HitRecord closestHit{};
 	pScene->GetClosestHit(viewRay, closestHit);
 
-	ColorRGB finalColor{};
-	const Vector3 hitPlusOffset{ closestHit.origin + closestHit.normal * 0.001f };
+	const ColorRGB color{ ShadePixel(pScene, viewRay, closestHit, GetLightSeed(pixelIndex, m_SampleIndex == 0), m_AllLights, materials, lights, occluders) };
+	AccumulateSample(pixelIndex, color, m_SampleIndex == 0);
+	if (m_SampleIndex == 0) StorePrimarySample(pixelIndex, closestHit, color);
+}
+
+void dae::Renderer::RenderTile(Scene* pScene, uint32_t tileIndex, uint32_t tileCountX, float fov, float aspectRatio, const Matrix& cameraToWorld, const Vector3& cameraOrigin, const std::vector<dae::MaterialData>& materials, std::vector<dae::Light>& lights) const
+{
+	uint32_t startX{}, startY{}, endX{}, endY{};
+	GetTileBounds(tileIndex, tileCountX, startX, startY, endX, endY);
+
+	if (m_WavefrontEnabled)
+	{
+		RenderTileWavefront(pScene, tileIndex, tileCountX, fov, aspectRatio, cameraToWorld, cameraOrigin, materials, lights);
+		return;
+	}
+
+	//a tile never leaves its thread, so its shadow rays can share an occluder cache without any locking
+	std::vector<Occluder> occluders(lights.size());
+
+	if (m_PacketTracingEnabled)
+	{
+		std::vector<uint32_t> lightList{};
+		for (uint32_t y{ startY }; y < endY; y += RayPacket::TileSize)
+		{
+			for (uint32_t x{ startX }; x < endX; x += RayPacket::TileSize)
+			{
+				RenderPacket(pScene, x, y, fov, aspectRatio, cameraToWorld, cameraOrigin, materials, lights, occluders, lightList);
+			}
+		}
+	}
+	else
+	{
+		for (uint32_t py{ startY }; py < endY; ++py)
+		{
+			for (uint32_t px{ startX }; px < endX; ++px)
+			{
+				RenderPixel(pScene, px + py * m_Width, fov, aspectRatio, cameraToWorld, cameraOrigin, materials, lights, occluders);
+			}
+		}
+	}
+}
+
+void dae::Renderer::RenderPacket(Scene* pScene, uint32_t x, uint32_t y, float fov, float aspectRatio, const Matrix& cameraToWorld, const Vector3& cameraOrigin, const std::vector<dae::MaterialData>& materials, std::vector<dae::Light>& lights, std::vector<Occluder>& occluders, std::vector<uint32_t>& lightList) const
+{
+	RayPacket packet{};
+	packet.origin = cameraOrigin;
+	for (uint32_t lane{}; lane < RayPacket::Size; ++lane)
+	{
+		const uint32_t px{ x + RayPacket::GetLaneX(lane) }, py{ y + RayPacket::GetLaneY(lane) };
+		if (px >= uint32_t(m_Width) || py >= uint32_t(m_Height) || !NeedsSample(px + py * m_Width)) continue;
+
+		float offsetX{}, offsetY{};
+		GetSampleOffset(px + py * m_Width, offsetX, offsetY);
+		packet.SetDirection(lane, GetViewDirection(px + offsetX, py + offsetY, fov, aspectRatio, cameraToWorld));
+	}
+
+	if (packet.activeMask == 0) return;
 
-	if (closestHit.didHit)
+	HitRecord closestHits[RayPacket::Size]{};
+	pScene->GetClosestHits(packet, closestHits);
+
+	//the block only goes over the lights that reach the box around its hits
+	if (!IsSamplingLights(lights.size()))
 	{
-		for (int i{}; i < pScene->GetLights().size(); ++i)
+		Vector3 minHit{ FLT_MAX, FLT_MAX, FLT_MAX }, maxHit{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		for (uint32_t lane{}; lane < RayPacket::Size; ++lane)
 		{
-			Vector3 toHitVector{ hitPlusOffset - lights[i].origin };
-			Vector3 l{ toHitVector.Normalized() };
+			if (!packet.IsActive(lane) || !closestHits[lane].didHit) continue;
+			minHit = Vector3::Min(minHit, closestHits[lane].origin);
+			maxHit = Vector3::Max(maxHit, closestHits[lane].origin);
+		}
+		CullLights(minHit, maxHit, lightList);
+	}
+
+	for (uint32_t lane{}; lane < RayPacket::Size; ++lane)
+	{
+		if (!packet.IsActive(lane)) continue;
+
+		const uint32_t pixelIndex{ x + RayPacket::GetLaneX(lane) + (y + RayPacket::GetLaneY(lane)) * m_Width };
+		const ColorRGB color{ ShadePixel(pScene, packet.GetRay(lane), closestHits[lane], GetLightSeed(pixelIndex, m_SampleIndex == 0), lightList, materials, lights, occluders) };
+		AccumulateSample(pixelIndex, color, m_SampleIndex == 0);
+		if (m_SampleIndex == 0) StorePrimarySample(pixelIndex, closestHits[lane], color);
+	}
+}
+
+void dae::Renderer::RenderTileWavefront(Scene* pScene, uint32_t tileIndex, uint32_t tileCountX, float fov, float aspectRatio, const Matrix& cameraToWorld, const Vector3& cameraOrigin, const std::vector<dae::MaterialData>& materials, std::vector<dae::Light>& lights) const
+{
+	//one set of queues per worker thread, they only ever grow to the size of a tile
+	thread_local WavefrontQueues queues{};
+
+	GenerateCameraRays(tileIndex, tileCountX, fov, aspectRatio, cameraToWorld, queues);
+	TraceCameraRays(pScene, cameraOrigin, queues);
+	GenerateShadowRays(pScene, lights, queues);
+	if (m_ShadowsEnabled)
+	{
+		if (m_RayBinningEnabled) BinShadowRays(queues);
+		if (IsSamplingLights(lights.size())) GroupShadowRaysByLight(uint32_t(lights.size()), queues);
+		TraceShadowRays(pScene, lights, queues);
+	}
+	ShadeHits(materials, lights, queues);
+}
+
+void dae::Renderer::GenerateCameraRays(uint32_t tileIndex, uint32_t tileCountX, float fov, float aspectRatio, const Matrix& cameraToWorld, WavefrontQueues& queues) const
+{
+	uint32_t startX{}, startY{}, endX{}, endY{};
+	GetTileBounds(tileIndex, tileCountX, startX, startY, endX, endY);
 
-			Ray toLightRay{ lights[i].origin, l, 0.0f, toHitVector.Magnitude() };
+	CameraRayQueue& cameraRays{ queues.cameraRays };
+	cameraRays.Clear();
 
-			// skip light calculation when light does not hit pixel
-			if (m_ShadowsEnabled && pScene->DoesHit(toLightRay)) continue;
+	//4x4 blocks in lane order, so the closest-hit stage can cut the queue into coherent packets
+	for (uint32_t y{ startY }; y < endY; y += RayPacket::TileSize)
+	{
+		for (uint32_t x{ startX }; x < endX; x += RayPacket::TileSize)
+		{
+			for (uint32_t lane{}; lane < RayPacket::Size; ++lane)
+			{
+				const uint32_t px{ x + RayPacket::GetLaneX(lane) }, py{ y + RayPacket::GetLaneY(lane) };
+				const uint32_t pixelIndex{ px + py * m_Width };
+				if (px >= endX || py >= endY || !NeedsSample(pixelIndex)) continue;
+
+				float offsetX{}, offsetY{};
+				GetSampleOffset(pixelIndex, offsetX, offsetY);
+				cameraRays.Push(pixelIndex, GetViewDirection(px + offsetX, py + offsetY, fov, aspectRatio, cameraToWorld));
+			}
+		}
+	}
+}
 
-			float cosineLaw{ std::max(0.f, Vector3::Dot(closestHit.normal, -toLightRay.direction)) };
+void dae::Renderer::TraceCameraRays(Scene* pScene, const Vector3& cameraOrigin, WavefrontQueues& queues) const
+{
+	const CameraRayQueue& cameraRays{ queues.cameraRays };
+	HitQueue& hits{ queues.hits };
+	hits.Clear();
 
-			switch (m_CurrentLightingMode)
+	const auto addHit{ [&](uint32_t ray, const HitRecord& closestHit)
+		{
+			const uint32_t pixelIndex{ cameraRays.pixelIndices[ray] };
+			if (closestHit.didHit)
 			{
-			case dae::Renderer::LightingMode::ObservedArea:
+				hits.Push(pixelIndex, closestHit, cameraRays.GetDirection(ray));
+				return;
+			}
+
+			//nothing to light, the background stays black
+			AccumulateSample(pixelIndex, {}, m_SampleIndex == 0);
+			if (m_SampleIndex == 0) StorePrimarySample(pixelIndex, closestHit, {});
+		} };
+
+	const uint32_t rayCount{ cameraRays.GetSize() };
+	if (!m_PacketTracingEnabled)
+	{
+		for (uint32_t ray{}; ray < rayCount; ++ray)
+		{
+			HitRecord closestHit{};
+			pScene->GetClosestHit(Ray{ cameraOrigin, cameraRays.GetDirection(ray) }, closestHit);
+			addHit(ray, closestHit);
+		}
+		return;
+	}
+
+	for (uint32_t first{}; first < rayCount; first += RayPacket::Size)
+	{
+		RayPacket packet{};
+		packet.origin = cameraOrigin;
+		const uint32_t laneCount{ std::min(rayCount - first, RayPacket::Size) };
+		for (uint32_t lane{}; lane < laneCount; ++lane)
+		{
+			packet.SetDirection(lane, cameraRays.GetDirection(first + lane));
+		}
+
+		HitRecord closestHits[RayPacket::Size]{};
+		pScene->GetClosestHits(packet, closestHits);
+		for (uint32_t lane{}; lane < laneCount; ++lane)
+		{
+			addHit(first + lane, closestHits[lane]);
+		}
+	}
+}
+
+void dae::Renderer::GenerateShadowRays(Scene* pScene, const std::vector<dae::Light>& lights, WavefrontQueues& queues) const
+{
+	const HitQueue& hits{ queues.hits };
+	ShadowRayQueue& shadowRays{ queues.shadowRays };
+	const uint32_t hitCount{ hits.GetSize() };
+	const bool isSamplingLights{ IsSamplingLights(lights.size()) };
+
+	//without sampling, a slot per light that reaches the box around the tile's hits
+	std::vector<uint32_t>& tileLights{ queues.tileLights };
+	if (!isSamplingLights)
+	{
+		Vector3 minHit{ FLT_MAX, FLT_MAX, FLT_MAX }, maxHit{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		for (uint32_t hit{}; hit < hitCount; ++hit)
+		{
+			minHit = Vector3::Min(minHit, hits.GetPosition(hit));
+			maxHit = Vector3::Max(maxHit, hits.GetPosition(hit));
+		}
+		CullLights(minHit, maxHit, tileLights);
+	}
+	shadowRays.Resize(hitCount, isSamplingLights ? m_LightSampleCount : uint32_t(tileLights.size()));
+
+	//the same rays ShadePixel casts, from the light towards a point just above the surface
+	for (uint32_t hit{}; hit < hitCount; ++hit)
+	{
+		const Vector3 normal{ hits.normalX[hit], hits.normalY[hit], hits.normalZ[hit] };
+		const Vector3 hitPlusOffset{ hits.GetPosition(hit) + normal * 0.001f };
+		const uint32_t seed{ isSamplingLights ? GetLightSeed(hits.pixelIndices[hit], m_SampleIndex == 0) : 0 };
+
+		for (uint32_t slot{}; slot < shadowRays.slotCount; ++slot)
+		{
+			const uint32_t ray{ slot * hitCount + hit };
+			float weight{ 1.f };
+			uint32_t light{ isSamplingLights ? SampleLight(pScene, hitPlusOffset, normal, seed, slot, weight) : tileLights[slot] };
+			if (!isSamplingLights && !IsInLightRange(light, hits.GetPosition(hit))) light = LightTree::InvalidLight;
+			shadowRays.order[ray] = ray;
+			shadowRays.lightIndices[ray] = light;
+			shadowRays.weights[ray] = weight;
+			if (light == LightTree::InvalidLight)
 			{
-				finalColor += ColorRGB{ 1.f, 1.f, 1.f } *cosineLaw;
+				shadowRays.directionX[ray] = shadowRays.directionY[ray] = shadowRays.directionZ[ray] = 0.f;
+				shadowRays.maxDistances[ray] = 0.f;
+				shadowRays.isVisible[ray] = false;
+				continue;
 			}
-			break;
 
-			case dae::Renderer::LightingMode::Radiance:
+			const Vector3 toHitVector{ hitPlusOffset - lights[light].origin };
+			const Vector3 l{ toHitVector.Normalized() };
+			shadowRays.directionX[ray] = l.x;
+			shadowRays.directionY[ray] = l.y;
+			shadowRays.directionZ[ray] = l.z;
+			shadowRays.maxDistances[ray] = toHitVector.Magnitude();
+			shadowRays.isVisible[ray] = true;
+		}
+	}
+}
+
+void dae::Renderer::BinShadowRays(WavefrontQueues& queues) const
+{
+	const HitQueue& hits{ queues.hits };
+	ShadowRayQueue& shadowRays{ queues.shadowRays };
+	const uint32_t hitCount{ hits.GetSize() };
+	if (hitCount == 0) return;
+
+	//the Morton grid spans the hits of this tile, whatever their scale in the scene
+	Vector3 minHit{ hits.GetPosition(0) }, maxHit{ minHit };
+	for (uint32_t hit{ 1 }; hit < hitCount; ++hit)
+	{
+		minHit = Vector3::Min(minHit, hits.GetPosition(hit));
+		maxHit = Vector3::Max(maxHit, hits.GetPosition(hit));
+	}
+	const Vector3 extent{ maxHit - minHit };
+	const float cellScale{ BinGridSize - .001f };
+	const Vector3 toGrid{ extent.x > 0.f ? cellScale / extent.x : 0.f, extent.y > 0.f ? cellScale / extent.y : 0.f, extent.z > 0.f ? cellScale / extent.z : 0.f };
+
+	std::vector<uint16_t>& hitCells{ queues.hitCells };
+	hitCells.resize(hitCount);
+	for (uint32_t hit{}; hit < hitCount; ++hit)
+	{
+		const Vector3 cell{ hits.GetPosition(hit) - minHit };
+		hitCells[hit] = uint16_t(MortonCode3(uint32_t(cell.x * toGrid.x), uint32_t(cell.y * toGrid.y), uint32_t(cell.z * toGrid.z)));
+	}
+
+	//counting sort, a tile holds too few rays to be worth a comparison sort. It is stable, so inside a bin the rays keep
+	//the 4x4 pixel blocks the camera rays were queued in
+	std::vector<uint16_t>& rayBins{ queues.rayBins };
+	rayBins.resize(hitCount);
+	for (uint32_t slot{}; slot < shadowRays.slotCount; ++slot)
+	{
+		const uint32_t first{ slot * hitCount };
+		uint32_t binStarts[BinCount + 1]{};
+		for (uint32_t hit{}; hit < hitCount; ++hit)
+		{
+			//rays of one octant agree on the order they visit BVH children in
+			const uint32_t ray{ first + hit };
+			const uint32_t octant{ uint32_t(shadowRays.directionX[ray] < 0.f) | uint32_t(shadowRays.directionY[ray] < 0.f) << 1 | uint32_t(shadowRays.directionZ[ray] < 0.f) << 2 };
+			rayBins[hit] = uint16_t(octant * BinCellCount + hitCells[hit]);
+			++binStarts[rayBins[hit] + 1];
+		}
+		for (uint32_t bin{}; bin < BinCount; ++bin) binStarts[bin + 1] += binStarts[bin];
+		for (uint32_t hit{}; hit < hitCount; ++hit) shadowRays.order[first + binStarts[rayBins[hit]]++] = first + hit;
+	}
+}
+
+void dae::Renderer::GroupShadowRaysByLight(uint32_t lightCount, WavefrontQueues& queues) const
+{
+	ShadowRayQueue& shadowRays{ queues.shadowRays };
+	const uint32_t hitCount{ shadowRays.hitCount };
+	std::vector<uint32_t>& lightStarts{ queues.lightStarts };
+	std::vector<uint32_t>& groupedOrder{ queues.groupedOrder };
+	groupedOrder.resize(hitCount);
+
+	//counting sort on top of whatever order binning left, rays without a light go last
+	const auto getGroup{ [&](uint32_t ray) { return std::min(shadowRays.lightIndices[ray], lightCount); } };
+	for (uint32_t slot{}; slot < shadowRays.slotCount; ++slot)
+	{
+		const uint32_t first{ slot * hitCount };
+		lightStarts.assign(lightCount + 2, 0);
+		for (uint32_t i{ first }; i < first + hitCount; ++i) ++lightStarts[getGroup(shadowRays.order[i]) + 1];
+		for (uint32_t group{}; group <= lightCount; ++group) lightStarts[group + 1] += lightStarts[group];
+		for (uint32_t i{ first }; i < first + hitCount; ++i) groupedOrder[lightStarts[getGroup(shadowRays.order[i])]++] = shadowRays.order[i];
+		std::copy(groupedOrder.begin(), groupedOrder.end(), shadowRays.order.begin() + first);
+	}
+}
+
+void dae::Renderer::TraceShadowRays(Scene* pScene, const std::vector<dae::Light>& lights, WavefrontQueues& queues) const
+{
+	ShadowRayQueue& shadowRays{ queues.shadowRays };
+	const uint32_t hitCount{ shadowRays.hitCount };
+
+	//an occluder cache per light, its rays can be spread over several slots
+	std::vector<Occluder>& occluders{ queues.occluders };
+	occluders.assign(lights.size(), {});
+
+	const uint64_t visitedNodeCount{ GeometryUtils::g_VisitedNodeCount };
+	uint64_t rayCount{};
+	for (uint32_t slot{}; slot < shadowRays.slotCount; ++slot)
+	{
+		const uint32_t end{ (slot + 1) * hitCount };
+		for (uint32_t i{ slot * hitCount }; i < end;)
+		{
+			const uint32_t light{ shadowRays.lightIndices[shadowRays.order[i]] };
+			if (light == LightTree::InvalidLight)
 			{
-				finalColor += LightUtils::GetRadiance(pScene->GetLights()[i], closestHit.origin);
+				++i;
+				continue;
 			}
-			break;
 
-			case dae::Renderer::LightingMode::BDRF:
+			if (!m_PacketTracingEnabled)
 			{
-				finalColor += materials[closestHit.materialIndex]->Shade(closestHit, -l, v);
+				const uint32_t ray{ shadowRays.order[i] };
+				const Ray toLightRay{ lights[light].origin, shadowRays.GetDirection(ray), 0.0f, shadowRays.maxDistances[ray] };
+				shadowRays.isVisible[ray] = !pScene->DoesHit(toLightRay, occluders[light]);
+				++rayCount;
+				++i;
+				continue;
 			}
-			break;
 
-			case dae::Renderer::LightingMode::Combined:
+			//rays towards the same light share its origin, up to 16 of them in a row go down the BVH together
+			RayPacket packet{};
+			packet.origin = lights[light].origin;
+			packet.min = 0.0f;
+			alignas(16) float maxDistances[RayPacket::Size]{};
+			uint32_t laneCount{};
+			for (; laneCount < RayPacket::Size && i + laneCount < end; ++laneCount)
 			{
-				finalColor += LightUtils::GetRadiance(pScene->GetLights()[i], closestHit.origin) * materials[closestHit.materialIndex]->Shade(closestHit, -l, v) * cosineLaw;
+				const uint32_t ray{ shadowRays.order[i + laneCount] };
+				if (shadowRays.lightIndices[ray] != light) break;
+
+				packet.SetDirection(laneCount, shadowRays.GetDirection(ray));
+				maxDistances[laneCount] = shadowRays.maxDistances[ray];
 			}
-			break;
+
+			const uint32_t occludedMask{ pScene->GetOccludedLanes(packet, maxDistances, occluders[light]) };
+			for (uint32_t lane{}; lane < laneCount; ++lane)
+			{
+				shadowRays.isVisible[shadowRays.order[i + lane]] = !((occludedMask >> lane) & 1);
 			}
+			rayCount += laneCount;
+			i += laneCount;
 		}
 	}
 
-	//Update Color in Buffer
-	finalColor.MaxToOne();
+	m_ShadowRayCount += rayCount;
+	m_ShadowNodeCount += GeometryUtils::g_VisitedNodeCount - visitedNodeCount;
+}
+
+template<dae::Renderer::LightingMode Mode, bool IsFastMath>
+void dae::Renderer::ShadeHits(const std::vector<dae::MaterialData>& materials, std::vector<dae::Light>& lights, WavefrontQueues& queues) const
+{
+	const HitQueue& hits{ queues.hits };
+	const ShadowRayQueue& shadowRays{ queues.shadowRays };
+	const uint32_t hitCount{ hits.GetSize() };
+
+	//counting sort by material, stable so the hits of a material keep their screen order
+	std::vector<uint32_t>& shadingOrder{ queues.shadingOrder };
+	shadingOrder.resize(hitCount);
+	uint32_t materialStarts[256 + 1]{};
+	for (uint32_t hit{}; hit < hitCount; ++hit) ++materialStarts[hits.materialIndices[hit] + 1];
+	for (uint32_t material{}; material < 256; ++material) materialStarts[material + 1] += materialStarts[material];
+	for (uint32_t hit{}; hit < hitCount; ++hit) shadingOrder[materialStarts[hits.materialIndices[hit]]++] = hit;
+
+	//brdf is one type's function from MaterialShading, known at compile time, so the batch runs without a call per light
+	const auto shadeBatch{ [&](uint32_t first, uint32_t last, const auto& brdf)
+		{
+			for (uint32_t i{ first }; i < last; ++i)
+			{
+				const uint32_t hit{ shadingOrder[i] };
+				const HitRecord closestHit{ hits.GetHitRecord(hit) };
+				const Vector3 v{ hits.GetViewDirection(hit) * -1 };
+
+				ColorRGB finalColor{};
+				for (uint32_t slot{}; slot < shadowRays.slotCount; ++slot)
+				{
+					const uint32_t ray{ slot * hitCount + hit };
+					if (!shadowRays.isVisible[ray]) continue;
+
+					const ColorRGB color{ ShadeLight<Mode, IsFastMath>(closestHit, lights[shadowRays.lightIndices[ray]], shadowRays.GetDirection(ray), v, brdf) };
+					const float weight{ shadowRays.weights[ray] };
+					finalColor += weight == 1.f ? color : color * weight;
+				}
+				const uint32_t pixelIndex{ hits.pixelIndices[hit] };
+				AccumulateSample(pixelIndex, finalColor, m_SampleIndex == 0);
+				if (m_SampleIndex == 0) StorePrimarySample(pixelIndex, closestHit, finalColor);
+			}
+		} };
+
+	//the sort left every material's end in its start, the materials go by type so the same BRDF runs back to back
+	for (const uint32_t material : m_MaterialOrder)
+	{
+		const uint32_t first{ material == 0 ? 0 : materialStarts[material - 1] }, last{ materialStarts[material] };
+		if (first == last) continue;
 
-	m_pBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBuffer->format,
-		static_cast<uint8_t>(finalColor.r * 255),
-		static_cast<uint8_t>(finalColor.g * 255),
-		static_cast<uint8_t>(finalColor.b * 255));
+		MaterialShading::Dispatch<IsFastMath>(materials[material], [&](const auto& brdf) { shadeBatch(first, last, brdf); });
+	}
 }
 
-bool Renderer::SaveBufferToImage() const
+void dae::Renderer::RefineEdges(Scene* pScene, uint32_t tileIndex, uint32_t tileCountX, float fov, float aspectRatio, const Matrix& cameraToWorld, const Vector3& cameraOrigin, const std::vector<dae::MaterialData>& materials, std::vector<dae::Light>& lights) const
 {
-	return SDL_SaveBMP(m_pBuffer, "RayTracing_Buffer.bmp");
+	uint32_t startX{}, startY{}, endX{}, endY{};
+	GetTileBounds(tileIndex, tileCountX, startX, startY, endX, endY);
+
+	std::vector<Occluder> occluders(lights.size());
+	uint32_t edgePixelCount{};
+
+	for (uint32_t py{ startY }; py < endY; ++py)
+	{
+		for (uint32_t px{ startX }; px < endX; ++px)
+		{
+			//reused pixels bring their anti-aliasing along
+			if (IsPixelReused(px + py * m_Width) || !IsEdgePixel(px, py)) continue;
+			++edgePixelCount;
+
+			//edge pixels are scattered along silhouettes, too sparse to fill ray packets
+			for (uint32_t sample{ 1 }; sample <= m_EdgeSampleCount; ++sample)
+			{
+				Ray viewRay{ cameraOrigin };
+				viewRay.direction = GetViewDirection(px + Halton(sample, 2), py + Halton(sample, 3), fov, aspectRatio, cameraToWorld);
+
+				HitRecord closestHit{};
+				pScene->GetClosestHit(viewRay, closestHit);
+
+				const uint32_t pixelIndex{ px + py * m_Width };
+				AccumulateSample(pixelIndex, ShadePixel(pScene, viewRay, closestHit, GetLightSeed(pixelIndex, false), m_AllLights, materials, lights, occluders), false);
+			}
+		}
+	}
+	m_EdgePixelCount += edgePixelCount;
 }
 
-void dae::Renderer::CycleLigntingMode()
+bool Renderer::IsEdgePixel(uint32_t px, uint32_t py) const
 {
-	HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
-	SetConsoleTextAttribute(hConsole, 0x0c);
+	const PrimarySample& center{ m_PrimarySamples[px + py * m_Width] };
 
-	m_CurrentLightingMode = static_cast<LightingMode>(int(m_CurrentLightingMode) + 1);
-	if (int(m_CurrentLightingMode) > 3)
-		m_CurrentLightingMode = LightingMode::ObservedArea;
+	const auto differs{ [&](uint32_t x, uint32_t y)
+		{
+			const PrimarySample& neighbour{ m_PrimarySamples[x + y * m_Width] };
+			if (std::abs(neighbour.luminance - center.luminance) > m_EdgeThreshold) return true;
 
-	std::cout << "LigtingMode ";
+			const bool centerHit{ center.depth != FLT_MAX }, neighbourHit{ neighbour.depth != FLT_MAX };
+			if (centerHit != neighbourHit) return true;
+			if (!centerHit) return false;
 
-	switch (m_CurrentLightingMode)
-	{
-	case dae::Renderer::LightingMode::ObservedArea:
-		std::cout << "ObservedArea";
-		break;
+			return neighbour.materialIndex != center.materialIndex
+				|| std::abs(neighbour.depth - center.depth) > m_EdgeThreshold * std::min(neighbour.depth, center.depth);
+		} };
 
-	case dae::Renderer::LightingMode::Radiance:
-		std::cout << "Radiance";
-		break;
+	return (px > 0 && differs(px - 1, py))
+		|| (px + 1 < uint32_t(m_Width) && differs(px + 1, py))
+		|| (py > 0 && differs(px, py - 1))
+		|| (py + 1 < uint32_t(m_Height) && differs(px, py + 1));
+}
 
-	case dae::Renderer::LightingMode::BDRF:
-		std::cout << "BDRF";
-		break;
+void Renderer::GetTileBounds(uint32_t tileIndex, uint32_t tileCountX, uint32_t& startX, uint32_t& startY, uint32_t& endX, uint32_t& endY) const
+{
+	startX = tileIndex % tileCountX * m_TileSize;
+	startY = tileIndex / tileCountX * m_TileSize;
+	endX = std::min(startX + m_TileSize, uint32_t(m_Width));
+	endY = std::min(startY + m_TileSize, uint32_t(m_Height));
+}
 
-	case dae::Renderer::LightingMode::Combined:
-		std::cout << "Combined";
-		break;
+void Renderer::CountUnconvergedPixels(uint32_t tileIndex, uint32_t tileCountX) const
+{
+	uint32_t startX{}, startY{}, endX{}, endY{};
+	GetTileBounds(tileIndex, tileCountX, startX, startY, endX, endY);
+
+	uint32_t unconvergedPixelCount{};
+	for (uint32_t py{ startY }; py < endY; ++py)
+	{
+		for (uint32_t px{ startX }; px < endX; ++px)
+		{
+			if (!IsPixelConverged(px + py * m_Width)) ++unconvergedPixelCount;
+		}
 	}
+	m_UnconvergedPixelCount += unconvergedPixelCount;
+}
 
-	std::cout << std::endl;
+Vector3 dae::Renderer::GetViewDirection(float x, float y, float fov, float aspectRatio, const Matrix& cameraToWorld) const
+{
+	float cx{ (2 * (x / float(m_Width)) - 1) * aspectRatio * fov };
+	float cy{ (1 - (2 * (y / float(m_Height)))) * fov };
 
-	SetConsoleTextAttribute(hConsole, 0x07);
+	Vector3 rayDirection{ cx, cy, 1 };
+	return cameraToWorld.TransformVector(rayDirection.Normalized());
 }
 
-void dae::Renderer::ToggleShadows()
+template<dae::Renderer::LightingMode Mode, bool HasShadows, bool IsFastMath>
+ColorRGB dae::Renderer::ShadePixel(Scene* pScene, const Ray& viewRay, const HitRecord& closestHit, uint32_t seed, const std::vector<uint32_t>& lightList, const std::vector<dae::MaterialData>& materials, std::vector<dae::Light>& lights, std::vector<Occluder>& occluders) const
 {
-	m_ShadowsEnabled = !m_ShadowsEnabled;
+	Vector3 v{ viewRay.direction * -1 };
 
-	HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
-	SetConsoleTextAttribute(hConsole, 0x0c);
+	ColorRGB finalColor{};
+	if (!closestHit.didHit) return finalColor;
 
-	std::cout <<  "Shadows " << std::boolalpha << m_ShadowsEnabled << std::endl;
+	const Vector3 hitPlusOffset{ closestHit.origin + closestHit.normal * 0.001f };
+
+	//the light loops below are compiled once per material type
+	MaterialShading::Dispatch<IsFastMath>(materials[closestHit.materialIndex], [&](const auto& brdf)
+		{
+			const auto addLight{ [&](uint32_t i, float weight)
+				{
+					Vector3 toHitVector{ hitPlusOffset - lights[i].origin };
+					Vector3 l{ toHitVector.Normalized() };
+
+					Ray toLightRay{ lights[i].origin, l, 0.0f, toHitVector.Magnitude() };
+
+					// skip light calculation when light does not hit pixel
+					if constexpr (HasShadows)
+					{
+						if (pScene->DoesHit(toLightRay, occluders[i])) return;
+					}
+
+					const ColorRGB color{ ShadeLight<Mode, IsFastMath>(closestHit, lights[i], l, v, brdf) };
+					finalColor += weight == 1.f ? color : color * weight;
+				} };
+
+			if (!IsSamplingLights(lights.size()))
+			{
+				//lights out of range add less than the cutoff, not worth a shadow ray
+				for (const uint32_t i : lightList)
+				{
+					if (IsInLightRange(i, closestHit.origin)) addLight(i, 1.f);
+				}
+			}
+			else
+			{
+				for (uint32_t sample{}; sample < m_LightSampleCount; ++sample)
+				{
+					float weight{};
+					const uint32_t i{ SampleLight(pScene, hitPlusOffset, closestHit.normal, seed, sample, weight) };
+					if (i != LightTree::InvalidLight) addLight(i, weight);
+				}
+			}
+		});
+
+	return finalColor;
+}
+
+void dae::Renderer::CullLights(const Vector3& minAABB, const Vector3& maxAABB, std::vector<uint32_t>& lightList) const
+{
+	lightList.clear();
+	for (uint32_t i{}; i < m_LightOrigins.size(); ++i)
+	{
+		//closest point of the box, never further than any hit inside it, so no light IsInLightRange accepts is dropped
+		const Vector3 closestPoint{ Vector3::Max(minAABB, Vector3::Min(m_LightOrigins[i], maxAABB)) };
+		if ((closestPoint - m_LightOrigins[i]).SqrMagnitude() <= m_LightRadiiSqr[i]) lightList.push_back(i);
+	}
+}
+
+uint32_t dae::Renderer::GetLightSeed(uint32_t pixelIndex, bool isFirstSample) const
+{
+	//the first sample of a frame always draws the same lights, like it always goes through the pixel center
+	return Hash(pixelIndex + Hash(isFirstSample ? 0 : m_SampleCounts[pixelIndex]));
+}
+
+uint32_t dae::Renderer::SampleLight(Scene* pScene, const Vector3& hitPlusOffset, const Vector3& normal, uint32_t seed, uint32_t sample, float& weight) const
+{
+	//only the lighting modes with the cosine law are black where the lights are behind the surface
+	const bool isFrontFacingOnly{ m_CurrentLightingMode == LightingMode::ObservedArea || m_CurrentLightingMode == LightingMode::Combined };
+
+	float pdf{};
+	const uint32_t light{ pScene->GetLightTree().Sample(hitPlusOffset, normal, isFrontFacingOnly, GetRandom(seed, sample), pdf) };
+	weight = light == LightTree::InvalidLight ? 0.f : 1.f / (pdf * m_LightSampleCount);
+	return light;
+}
+
+template<dae::Renderer::LightingMode Mode, bool IsFastMath, typename BRDFFunction>
+ColorRGB dae::Renderer::ShadeLight(const HitRecord& closestHit, const Light& light, const Vector3& l, const Vector3& v, const BRDFFunction& brdf) const
+{
+	const auto radiance{ [&]() { return IsFastMath ? LightUtils::GetRadianceFast(light, closestHit.origin) : LightUtils::GetRadiance(light, closestHit.origin); } };
+
+	if constexpr (Mode == LightingMode::ObservedArea)
+		return ColorRGB{ 1.f, 1.f, 1.f } * std::max(0.f, Vector3::Dot(closestHit.normal, -l));
+	else if constexpr (Mode == LightingMode::Radiance)
+		return radiance();
+	else if constexpr (Mode == LightingMode::BDRF)
+		return brdf(closestHit.normal, -l, v);
+	else
+		return radiance() * brdf(closestHit.normal, -l, v) * std::max(0.f, Vector3::Dot(closestHit.normal, -l));
+}
+
+dae::Renderer::ShadePixelFunction dae::Renderer::GetShadePixelFunction(LightingMode mode, bool hasShadows, bool isFastMath)
+{
+	//[mode][hasShadows][isFastMath], in the order of LightingMode
+	static constexpr ShadePixelFunction functions[4][2][2]
+	{
+		{
+			{ &Renderer::ShadePixel<LightingMode::ObservedArea, false, false>, &Renderer::ShadePixel<LightingMode::ObservedArea, false, true> },
+			{ &Renderer::ShadePixel<LightingMode::ObservedArea, true, false>, &Renderer::ShadePixel<LightingMode::ObservedArea, true, true> }
+		},
+		{
+			{ &Renderer::ShadePixel<LightingMode::Radiance, false, false>, &Renderer::ShadePixel<LightingMode::Radiance, false, true> },
+			{ &Renderer::ShadePixel<LightingMode::Radiance, true, false>, &Renderer::ShadePixel<LightingMode::Radiance, true, true> }
+		},
+		{
+			{ &Renderer::ShadePixel<LightingMode::BDRF, false, false>, &Renderer::ShadePixel<LightingMode::BDRF, false, true> },
+			{ &Renderer::ShadePixel<LightingMode::BDRF, true, false>, &Renderer::ShadePixel<LightingMode::BDRF, true, true> }
+		},
+		{
+			{ &Renderer::ShadePixel<LightingMode::Combined, false, false>, &Renderer::ShadePixel<LightingMode::Combined, false, true> },
+			{ &Renderer::ShadePixel<LightingMode::Combined, true, false>, &Renderer::ShadePixel<LightingMode::Combined, true, true> }
+		}
+	};
+	return functions[int(mode)][hasShadows][isFastMath];
+}
+
+dae::Renderer::ShadeHitsFunction dae::Renderer::GetShadeHitsFunction(LightingMode mode, bool isFastMath)
+{
+	static constexpr ShadeHitsFunction functions[4][2]
+	{
+		{ &Renderer::ShadeHits<LightingMode::ObservedArea, false>, &Renderer::ShadeHits<LightingMode::ObservedArea, true> },
+		{ &Renderer::ShadeHits<LightingMode::Radiance, false>, &Renderer::ShadeHits<LightingMode::Radiance, true> },
+		{ &Renderer::ShadeHits<LightingMode::BDRF, false>, &Renderer::ShadeHits<LightingMode::BDRF, true> },
+		{ &Renderer::ShadeHits<LightingMode::Combined, false>, &Renderer::ShadeHits<LightingMode::Combined, true> }
+	};
+	return functions[int(mode)][isFastMath];
+}
+
+
+void Renderer::GetSampleOffset(uint32_t pixelIndex, float& offsetX, float& offsetY) const
+{
+	//the first sample goes through the pixel center, so a single sample renders exactly like before
+	if (m_SampleIndex == 0)
+	{
+		offsetX = offsetY = .5f;
+		return;
+	}
+	offsetX = Halton(m_SampleCounts[pixelIndex], 2);
+	offsetY = Halton(m_SampleCounts[pixelIndex], 3);
+}
+
+bool Renderer::IsPixelConverged(uint32_t pixelIndex) const
+{
+	const uint32_t sampleCount{ m_SampleCounts[pixelIndex] };
+	if (sampleCount >= m_MaxSamples) return true;
+	if (sampleCount < MinConvergenceSamples || m_ConvergenceThreshold <= 0.f) return false;
+
+	//standard error of the mean luminance: the sample variance divided by the sample count
+	const float luminanceSum{ m_LuminanceSums[pixelIndex] };
+	const float variance{ (m_LuminanceSquareSums[pixelIndex] - luminanceSum * luminanceSum / sampleCount) / (sampleCount - 1) };
+	return variance <= m_ConvergenceThreshold * m_ConvergenceThreshold * sampleCount;
+}
+
+void Renderer::AccumulateSample(uint32_t pixelIndex, const ColorRGB& color, bool isFirstSample) const
+{
+	const float luminance{ GetDisplayLuminance(color) };
+
+	//a reprojected sample only stands in until the pixel gets traced for real
+	ColorRGB& sum{ m_SampleSums[pixelIndex] };
+	uint16_t& age{ m_PrimarySamples[pixelIndex].age };
+	if (isFirstSample || age > 0)
+	{
+		age = 0;
+		sum = color;
+		m_LuminanceSums[pixelIndex] = luminance;
+		m_LuminanceSquareSums[pixelIndex] = luminance * luminance;
+		m_SampleCounts[pixelIndex] = 1;
+	}
+	else
+	{
+		sum = { sum.r + color.r, sum.g + color.g, sum.b + color.b };
+		m_LuminanceSums[pixelIndex] += luminance;
+		m_LuminanceSquareSums[pixelIndex] += luminance * luminance;
+		++m_SampleCounts[pixelIndex];
+	}
+}
+
+void Renderer::StorePrimarySample(uint32_t pixelIndex, const HitRecord& closestHit, const ColorRGB& color) const
+{
+	if (!m_EdgeAntiAliasingEnabled && !m_ReprojectionEnabled && !m_DirtyRegionsEnabled) return;
+
+	m_PrimarySamples[pixelIndex] = { closestHit.origin, closestHit.didHit ? closestHit.t : FLT_MAX, GetDisplayLuminance(color), 0, closestHit.materialIndex };
+}
+
+void Renderer::ReprojectPrimarySamples(const Matrix& cameraToWorld, const Vector3& cameraOrigin, float fov, float aspectRatio)
+{
+	//the camera matrix is orthonormal, projecting onto its axes is the inverse of GetViewDirection
+	const Vector3 right{ cameraToWorld.GetAxisX() }, up{ cameraToWorld.GetAxisY() }, forward{ cameraToWorld.GetAxisZ() };
+	const float scaleX{ .5f * m_Width / (aspectRatio * fov) }, scaleY{ .5f * m_Height / fov };
+	const uint32_t pixelCount{ uint32_t(m_Width * m_Height) };
+
+	for (ReprojectedSample& sample : m_ReprojectedSamples)
+	{
+		sample.viewDepth = FLT_MAX;
+		sample.primary.depth = FLT_MAX;
+	}
+
+	//forward scatter with a depth test, the nearest hit landing in a pixel wins. Serial, the pixels collide
+	for (uint32_t i{}; i < pixelCount; ++i)
+	{
+		const PrimarySample& source{ m_PrimarySamples[i] };
+		if (source.depth == FLT_MAX || source.age + 1u >= RefreshPeriod) continue;
+
+		const Vector3 toSample{ source.position - cameraOrigin };
+		const float viewZ{ Vector3::Dot(toSample, forward) };
+		if (viewZ <= 0.f) continue;
+
+		const float x{ .5f * m_Width + Vector3::Dot(toSample, right) / viewZ * scaleX };
+		const float y{ .5f * m_Height - Vector3::Dot(toSample, up) / viewZ * scaleY };
+		if (!(x >= 0.f && y >= 0.f && x < m_Width && y < m_Height)) continue;
+
+		//within one pixel the view depth orders the samples like the distance does
+		ReprojectedSample& target{ m_ReprojectedSamples[uint32_t(x) + uint32_t(y) * m_Width] };
+		if (viewZ >= target.viewDepth) continue;
+
+		//the accumulated color, an anti-aliased pixel stays anti-aliased while the camera moves
+		const ColorRGB& sum{ m_SampleSums[i] };
+		const float weight{ 1.f / m_SampleCounts[i] };
+		target.color = { sum.r * weight, sum.g * weight, sum.b * weight };
+		target.viewDepth = viewZ;
+		target.primary = source;
+		target.primary.depth = toSample.Magnitude();
+		++target.primary.age;
+	}
+}
+
+void Renderer::ApplyReprojectedSamples(uint32_t tileIndex, uint32_t tileCountX) const
+{
+	uint32_t startX{}, startY{}, endX{}, endY{};
+	GetTileBounds(tileIndex, tileCountX, startX, startY, endX, endY);
+
+	const uint32_t refreshSlice{ m_FrameIndex % RefreshPeriod };
+	uint32_t reprojectedPixelCount{};
+	for (uint32_t py{ startY }; py < endY; ++py)
+	{
+		for (uint32_t px{ startX }; px < endX; ++px)
+		{
+			const uint32_t pixelIndex{ px + py * m_Width };
+			const ReprojectedSample& sample{ m_ReprojectedSamples[pixelIndex] };
+			m_IsPixelReused[pixelIndex] = false;
+
+			//rolling refresh, view dependent shading cannot go stale for more than RefreshPeriod frames
+			if (sample.primary.depth == FLT_MAX || GetBayerIndex(px, py) == refreshSlice) continue;
+			if (m_HasMovedGeometry && IsNearChangedPixel(px, py)) continue;
+
+			//a sample much further away than a neighbour is most likely background showing through a hole in the foreground
+			const float maxDepth{ sample.viewDepth / 1.1f };
+			if ((px > 0 && m_ReprojectedSamples[pixelIndex - 1].viewDepth < maxDepth)
+				|| (px + 1 < uint32_t(m_Width) && m_ReprojectedSamples[pixelIndex + 1].viewDepth < maxDepth)
+				|| (py > 0 && m_ReprojectedSamples[pixelIndex - m_Width].viewDepth < maxDepth)
+				|| (py + 1 < uint32_t(m_Height) && m_ReprojectedSamples[pixelIndex + m_Width].viewDepth < maxDepth)) continue;
+
+			AccumulateSample(pixelIndex, sample.color, true);
+			m_PrimarySamples[pixelIndex] = sample.primary;
+			m_IsPixelReused[pixelIndex] = true;
+			++reprojectedPixelCount;
+		}
+	}
+	m_ReusedPixelCount += reprojectedPixelCount;
+}
+
+void Renderer::KeepUnchangedPixels(uint32_t tileIndex, uint32_t tileCountX) const
+{
+	uint32_t startX{}, startY{}, endX{}, endY{};
+	GetTileBounds(tileIndex, tileCountX, startX, startY, endX, endY);
+
+	//the accumulated samples stay as they are, including their anti-aliasing
+	uint32_t unchangedPixelCount{};
+	for (uint32_t py{ startY }; py < endY; ++py)
+	{
+		for (uint32_t px{ startX }; px < endX; ++px)
+		{
+			const bool isUnchanged{ !IsNearChangedPixel(px, py) };
+			m_IsPixelReused[px + py * m_Width] = isUnchanged;
+			if (isUnchanged) ++unchangedPixelCount;
+		}
+	}
+	m_ReusedPixelCount += unchangedPixelCount;
+}
+
+void Renderer::BuildChangeRegions(const Scene* pScene, const std::vector<dae::Light>& lights, const Matrix& cameraToWorld, const Vector3& cameraOrigin, float fov, float aspectRatio)
+{
+	//covers the shadow rays starting a little above the surface and the rounding of the projection
+	constexpr float margin{ .01f };
+
+	//every reused hit lies within this distance of the camera, which bounds how far a shadow has to be followed
+	float maxDepth{};
+	const uint32_t pixelCount{ uint32_t(m_Width * m_Height) };
+	for (uint32_t i{}; i < pixelCount; ++i)
+	{
+		const float depth{ GetReusedSample(i).depth };
+		if (depth != FLT_MAX) maxDepth = std::max(maxDepth, depth);
+	}
+
+	m_ChangeRegions.clear();
+	const std::vector<Vector3>& minAABBs{ pScene->GetChangedMinAABBs() };
+	const std::vector<Vector3>& maxAABBs{ pScene->GetChangedMaxAABBs() };
+	for (size_t box{}; box < minAABBs.size(); ++box)
+	{
+		ChangeRegion region{};
+		region.minAABB = minAABBs[box] - Vector3{ margin, margin, margin };
+		region.maxAABB = maxAABBs[box] + Vector3{ margin, margin, margin };
+
+		//8 corners of the box, followed by the same corners pushed away from a light
+		Vector3 corners[16]{};
+		for (uint32_t corner{}; corner < 8; ++corner)
+		{
+			corners[corner] = { corner & 1 ? region.maxAABB.x : region.minAABB.x, corner & 2 ? region.maxAABB.y : region.minAABB.y, corner & 4 ? region.maxAABB.z : region.minAABB.z };
+		}
+
+		//primary rays that can meet the box
+		region.lightIndex = NoLight;
+		if (GetScreenRect(corners, 8, cameraToWorld, cameraOrigin, fov, aspectRatio, region)) m_ChangeRegions.push_back(region);
+
+		//the shadow volume is the box scaled away from the light until it is as far away as the furthest hit can be
+		for (uint32_t light{}; light < lights.size(); ++light)
+		{
+			const Vector3& lightOrigin{ lights[light].origin };
+			const Vector3 closestPoint{ std::clamp(lightOrigin.x, region.minAABB.x, region.maxAABB.x), std::clamp(lightOrigin.y, region.minAABB.y, region.maxAABB.y), std::clamp(lightOrigin.z, region.minAABB.z, region.maxAABB.z) };
+			const float boxDistance{ (closestPoint - lightOrigin).Magnitude() };
+			const float maxHitDistance{ maxDepth + (cameraOrigin - lightOrigin).Magnitude() };
+
+			region.lightIndex = light;
+			if (boxDistance <= 0.f)
+			{
+				//the light sits inside the box, it can shadow anything
+				region.minX = region.minY = 0;
+				region.maxX = m_Width - 1;
+				region.maxY = m_Height - 1;
+				m_ChangeRegions.push_back(region);
+				continue;
+			}
+
+			const float scale{ std::max(maxHitDistance / boxDistance, 1.f) };
+			for (uint32_t corner{}; corner < 8; ++corner)
+			{
+				corners[8 + corner] = lightOrigin + (corners[corner] - lightOrigin) * scale;
+			}
+			if (GetScreenRect(corners, 16, cameraToWorld, cameraOrigin, fov, aspectRatio, region)) m_ChangeRegions.push_back(region);
+		}
+	}
+}
+
+bool Renderer::GetScreenRect(const Vector3* points, uint32_t pointCount, const Matrix& cameraToWorld, const Vector3& cameraOrigin, float fov, float aspectRatio, ChangeRegion& region) const
+{
+	constexpr uint32_t MaxPointCount{ 16 };
+	constexpr float nearDistance{ .001f };
+	assert(pointCount <= MaxPointCount);
+
+	//same projection as ReprojectPrimarySamples
+	const Vector3 right{ cameraToWorld.GetAxisX() }, up{ cameraToWorld.GetAxisY() }, forward{ cameraToWorld.GetAxisZ() };
+	const float scaleX{ .5f * m_Width / (aspectRatio * fov) }, scaleY{ .5f * m_Height / fov };
+
+	float minX{ FLT_MAX }, minY{ FLT_MAX }, maxX{ -FLT_MAX }, maxY{ -FLT_MAX };
+	const auto addPoint{ [&](const Vector3& toPoint, float viewZ)
+		{
+			const float x{ .5f * m_Width + Vector3::Dot(toPoint, right) / viewZ * scaleX };
+			const float y{ .5f * m_Height - Vector3::Dot(toPoint, up) / viewZ * scaleY };
+			minX = std::min(minX, x);
+			minY = std::min(minY, y);
+			maxX = std::max(maxX, x);
+			maxY = std::max(maxY, y);
+		} };
+
+	Vector3 toPoints[MaxPointCount]{};
+	float viewZs[MaxPointCount]{};
+	for (uint32_t i{}; i < pointCount; ++i)
+	{
+		toPoints[i] = points[i] - cameraOrigin;
+		viewZs[i] = Vector3::Dot(toPoints[i], forward);
+		if (viewZs[i] >= nearDistance) addPoint(toPoints[i], viewZs[i]);
+	}
+
+	//the part behind the camera is cut off where the edges between the points cross the near plane
+	for (uint32_t i{}; i < pointCount; ++i)
+	{
+		for (uint32_t j{ i + 1 }; j < pointCount; ++j)
+		{
+			if ((viewZs[i] >= nearDistance) == (viewZs[j] >= nearDistance)) continue;
+
+			const float t{ (nearDistance - viewZs[i]) / (viewZs[j] - viewZs[i]) };
+			addPoint(toPoints[i] + (toPoints[j] - toPoints[i]) * t, nearDistance);
+		}
+	}
+	if (minX > maxX) return false;
+
+	//clamped as floats first, points close to the near plane project far outside the screen
+	region.minX = int(std::clamp(minX, -1.f, float(m_Width)));
+	region.minY = int(std::clamp(minY, -1.f, float(m_Height)));
+	region.maxX = int(std::clamp(maxX, -1.f, float(m_Width)));
+	region.maxY = int(std::clamp(maxY, -1.f, float(m_Height)));
+	region.minX = std::max(region.minX, 0);
+	region.minY = std::max(region.minY, 0);
+	region.maxX = std::min(region.maxX, m_Width - 1);
+	region.maxY = std::min(region.maxY, m_Height - 1);
+	return region.minX <= region.maxX && region.minY <= region.maxY;
+}
+
+void Renderer::MarkChangedPixels(uint32_t tileIndex, uint32_t tileCountX, const std::vector<dae::Light>& lights) const
+{
+	uint32_t startX{}, startY{}, endX{}, endY{};
+	GetTileBounds(tileIndex, tileCountX, startX, startY, endX, endY);
+
+	std::vector<const ChangeRegion*> tileRegions{};
+	for (const ChangeRegion& region : m_ChangeRegions)
+	{
+		if (region.maxX >= int(startX) && region.minX < int(endX) && region.maxY >= int(startY) && region.minY < int(endY)) tileRegions.push_back(&region);
+	}
+
+	for (uint32_t py{ startY }; py < endY; ++py)
+	{
+		for (uint32_t px{ startX }; px < endX; ++px)
+		{
+			const PrimarySample& sample{ GetReusedSample(px + py * m_Width) };
+
+			bool isChanged{ false };
+			for (const ChangeRegion* pRegion : tileRegions)
+			{
+				if (int(px) < pRegion->minX || int(px) > pRegion->maxX || int(py) < pRegion->minY || int(py) > pRegion->maxY) continue;
+
+				//the rect of the box itself is taken as is, a shadow only matters when the hit's ray to the light crosses the box
+				isChanged = pRegion->lightIndex == NoLight
+					|| (sample.depth != FLT_MAX && GeometryUtils::SlabTest_Segment(pRegion->minAABB, pRegion->maxAABB, sample.position, lights[pRegion->lightIndex].origin));
+				if (isChanged) break;
+			}
+			m_IsPixelChanged[px + py * m_Width] = isChanged;
+		}
+	}
+}
+
+bool Renderer::IsNearChangedPixel(uint32_t px, uint32_t py) const
+{
+	const uint32_t startX{ px > 0 ? px - 1 : 0 }, endX{ std::min(px + 1, uint32_t(m_Width) - 1) };
+	const uint32_t startY{ py > 0 ? py - 1 : 0 }, endY{ std::min(py + 1, uint32_t(m_Height) - 1) };
+	for (uint32_t y{ startY }; y <= endY; ++y)
+	{
+		for (uint32_t x{ startX }; x <= endX; ++x)
+		{
+			if (m_IsPixelChanged[x + y * m_Width]) return true;
+		}
+	}
+	return false;
+}
+
+bool Renderer::SaveBufferToImage(const std::string& path) const
+{
+	return SaveBufferToImage(GetPixels(), path);
+}
+
+bool Renderer::SaveBufferToImage(const uint32_t* pPixels, const std::string& path) const
+{
+	std::ofstream file{ path, std::ios::binary };
+	if (!file) return false;
+
+	const auto hasExtension{ [&path](const char* pExtension) { return path.size() >= 4 && path.compare(path.size() - 4, 4, pExtension) == 0; } };
+
+	//HDR: the mean radiance of every pixel as little endian floats, exposed but not tonemapped, at the size it was traced.
+	//PFM rows go from the bottom up
+	if (hasExtension(".pfm"))
+	{
+		file << "PF\n" << m_Width << ' ' << m_Height << "\n-1.0\n";
+		std::vector<float> row(size_t(m_Width) * 3);
+		for (int y{ m_Height - 1 }; y >= 0; --y)
+		{
+			for (int x{}; x < m_Width; ++x)
+			{
+				const size_t pixelIndex{ size_t(y) * m_Width + x };
+				const float scale{ m_Tonemapper.GetExposureScale() / std::max(float(m_SampleCounts[pixelIndex]), 1.f) };
+				const ColorRGB& sum{ m_SampleSums[pixelIndex] };
+				row[x * 3] = sum.r * scale;
+				row[x * 3 + 1] = sum.g * scale;
+				row[x * 3 + 2] = sum.b * scale;
+			}
+			file.write(reinterpret_cast<const char*>(row.data()), std::streamsize(row.size() * sizeof(float)));
+		}
+		return bool(file);
+	}
+
+	//what is on screen, scaled up when the image was traced below full resolution
+	const int width{ m_OutputWidth }, height{ m_OutputHeight };
+
+	if (hasExtension(".ppm"))
+	{
+		file << "P6\n" << width << ' ' << height << "\n255\n";
+		for (size_t i{}; i < size_t(width) * height; ++i)
+		{
+			const uint32_t pixel{ pPixels[i] };
+			const char rgb[3]{ char(pixel >> 16), char(pixel >> 8), char(pixel) };
+			file.write(rgb, 3);
+		}
+		return bool(file);
+	}
+
+	//24 bit BMP: bottom-up BGR rows, each padded to a multiple of 4 bytes
+	const uint32_t rowSize{ (uint32_t(width) * 3 + 3) & ~3u };
+	const uint32_t imageSize{ rowSize * uint32_t(height) };
+	const auto writeValue{ [&file](uint32_t value, int byteCount)
+		{
+			for (int i{}; i < byteCount; ++i) file.put(char(value >> (i * 8)));
+		} };
+
+	file.put('B');
+	file.put('M');
+	writeValue(54 + imageSize, 4); //file size
+	writeValue(0, 4);
+	writeValue(54, 4); //pixel data offset
+	writeValue(40, 4); //info header size
+	writeValue(uint32_t(width), 4);
+	writeValue(uint32_t(height), 4);
+	writeValue(1, 2); //planes
+	writeValue(24, 2); //bits per pixel
+	writeValue(0, 4); //no compression
+	writeValue(imageSize, 4);
+	writeValue(2835, 4); //72 dpi
+	writeValue(2835, 4);
+	writeValue(0, 4);
+	writeValue(0, 4);
+
+	std::vector<char> row(rowSize, 0);
+	for (int y{ height - 1 }; y >= 0; --y)
+	{
+		for (int x{}; x < width; ++x)
+		{
+			const uint32_t pixel{ pPixels[x + y * width] };
+			row[x * 3] = char(pixel);
+			row[x * 3 + 1] = char(pixel >> 8);
+			row[x * 3 + 2] = char(pixel >> 16);
+		}
+		file.write(row.data(), rowSize);
+	}
+	return bool(file);
+}
+
+void dae::Renderer::CycleLigntingMode()
+{
+	SetConsoleColor(ConsoleColor::Red);
+
+	m_CurrentLightingMode = static_cast<LightingMode>(int(m_CurrentLightingMode) + 1);
+	ResetAccumulation();
+	if (int(m_CurrentLightingMode) > 3)
+		m_CurrentLightingMode = LightingMode::ObservedArea;
+
+	std::cout << "LigtingMode " << GetLightingModeName(m_CurrentLightingMode) << std::endl;
+
+	SetConsoleColor(ConsoleColor::Default);
+}
+
+const char* dae::Renderer::GetLightingModeName(LightingMode mode)
+{
+	switch (mode)
+	{
+	case dae::Renderer::LightingMode::ObservedArea:
+		return "ObservedArea";
+
+	case dae::Renderer::LightingMode::Radiance:
+		return "Radiance";
+
+	case dae::Renderer::LightingMode::BDRF:
+		return "BDRF";
+
+	case dae::Renderer::LightingMode::Combined:
+		return "Combined";
+	}
+	return "";
+}
+
+void dae::Renderer::PrintShadingBenchmark(Scene* pScene)
+{
+	constexpr int RUNS{ 5 };
+	const LightingMode lightingMode{ m_CurrentLightingMode };
+	const bool areShadowsEnabled{ m_ShadowsEnabled };
+
+	std::cout << "Shading variants at " << m_Width << 'x' << m_Height << " (best of " << RUNS << " full frames)" << std::endl;
+	for (int mode{}; mode < 4; ++mode)
+	{
+		for (const bool hasShadows : { false, true })
+		{
+			m_CurrentLightingMode = static_cast<LightingMode>(mode);
+			m_ShadowsEnabled = hasShadows;
+
+			//the best run is the one least disturbed by the rest of the system
+			double bestMs{ DBL_MAX };
+			for (int run{}; run < RUNS; ++run)
+			{
+				ResetAccumulation();
+				const auto start{ std::chrono::steady_clock::now() };
+				Render(pScene);
+				bestMs = std::min(bestMs, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+			}
+			std::cout << "  " << GetLightingModeName(m_CurrentLightingMode) << (hasShadows ? ", shadows: " : ", no shadows: ")
+				<< bestMs << " ms, " << m_Width * m_Height / (bestMs * 1000.0) << " Mpixels/s" << std::endl;
+		}
+	}
+
+	m_CurrentLightingMode = lightingMode;
+	m_ShadowsEnabled = areShadowsEnabled;
+	ResetAccumulation();
+}
+
+dae::Renderer::FastMathError dae::Renderer::CompareFastMath(Scene* pScene)
+{
+	constexpr int RUNS{ 3 };
+	const bool isFastMathEnabled{ m_FastMathEnabled };
+	const size_t pixelCount{ size_t(m_OutputWidth) * m_OutputHeight };
+
+	FastMathError error{};
+	std::vector<uint32_t> exactPixels{};
+	for (const bool isFastMath : { false, true })
+	{
+		m_FastMathEnabled = isFastMath;
+
+		double bestMs{ DBL_MAX };
+		for (int run{}; run < RUNS; ++run)
+		{
+			ResetAccumulation();
+			const auto start{ std::chrono::steady_clock::now() };
+			Render(pScene);
+			bestMs = std::min(bestMs, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+		}
+		(isFastMath ? error.fastMs : error.exactMs) = bestMs;
+		if (!isFastMath) exactPixels.assign(GetPixels(), GetPixels() + pixelCount);
+	}
+
+	//0xAARRGGBB, the three color channels of every pixel
+	const uint32_t* pFastPixels{ GetPixels() };
+	uint64_t errorSum{};
+	for (size_t i{}; i < pixelCount; ++i)
+	{
+		if (exactPixels[i] == pFastPixels[i]) continue;
+		++error.differingPixelCount;
+		for (const uint32_t shift : { 16u, 8u, 0u })
+		{
+			const int exact{ int(exactPixels[i] >> shift & 0xFF) }, fast{ int(pFastPixels[i] >> shift & 0xFF) };
+			const uint32_t channelError{ uint32_t(std::abs(exact - fast)) };
+			error.maxChannelError = std::max(error.maxChannelError, channelError);
+			errorSum += channelError;
+		}
+	}
+	error.meanChannelError = double(errorSum) / (3.0 * pixelCount);
+
+	m_FastMathEnabled = isFastMathEnabled;
+	ResetAccumulation();
+	return error;
+}
+
+void dae::Renderer::ToggleFastMath()
+{
+	m_FastMathEnabled = !m_FastMathEnabled;
+	ResetAccumulation();
+
+	SetConsoleColor(ConsoleColor::Red);
+
+	std::cout << "Fast math " << std::boolalpha << m_FastMathEnabled << std::endl;
+
+	SetConsoleColor(ConsoleColor::Default);
+}
+
+void dae::Renderer::ToggleShadows()
+{
+	m_ShadowsEnabled = !m_ShadowsEnabled;
+	ResetAccumulation();
+
+	SetConsoleColor(ConsoleColor::Red);
+
+	std::cout <<  "Shadows " << std::boolalpha << m_ShadowsEnabled << std::endl;
+
+	SetConsoleColor(ConsoleColor::Default);
+}
+
+void dae::Renderer::SetThreadCount(uint32_t threadCount)
+{
+	m_pThreadPool = std::make_unique<ThreadPool>(threadCount);
+}
+
+void dae::Renderer::SetTileSize(uint32_t tileSize)
+{
+	//tiles are split into whole packets, the packets on the image border mask off their outside lanes
+	m_TileSize = std::max((tileSize + RayPacket::TileSize - 1) / RayPacket::TileSize, 1u) * RayPacket::TileSize;
+}
+
+void dae::Renderer::TogglePacketTracing()
+{
+	m_PacketTracingEnabled = !m_PacketTracingEnabled;
+
+	SetConsoleColor(ConsoleColor::Red);
+
+	std::cout << "Packet tracing " << std::boolalpha << m_PacketTracingEnabled << std::endl;
+
+	SetConsoleColor(ConsoleColor::Default);
+}
+
+void dae::Renderer::SetExposure(float stops)
+{
+	m_Tonemapper.SetExposure(stops);
+
+	SetConsoleColor(ConsoleColor::Red);
+
+	std::cout << "Exposure " << stops << " stops" << std::endl;
+
+	SetConsoleColor(ConsoleColor::Default);
+}
+
+void dae::Renderer::CycleTonemapCurve()
+{
+	m_Tonemapper.CycleCurve();
+
+	SetConsoleColor(ConsoleColor::Red);
+
+	std::cout << "Tonemapping " << Tonemapper::GetCurveName(m_Tonemapper.GetCurve()) << std::endl;
+
+	SetConsoleColor(ConsoleColor::Default);
+}
+
+void dae::Renderer::ToggleSRGB()
+{
+	m_Tonemapper.SetSRGB(!m_Tonemapper.IsSRGB());
+
+	SetConsoleColor(ConsoleColor::Red);
+
+	std::cout << "sRGB output " << std::boolalpha << m_Tonemapper.IsSRGB() << std::endl;
+
+	SetConsoleColor(ConsoleColor::Default);
+}
+
+void dae::Renderer::ToggleAccumulation()
+{
+	m_AccumulationEnabled = !m_AccumulationEnabled;
+
+	SetConsoleColor(ConsoleColor::Red);
+
+	std::cout << "Accumulation " << std::boolalpha << m_AccumulationEnabled << std::endl;
+
+	SetConsoleColor(ConsoleColor::Default);
+}
+
+void dae::Renderer::ToggleEdgeAntiAliasing()
+{
+	m_EdgeAntiAliasingEnabled = !m_EdgeAntiAliasingEnabled;
+	ResetAccumulation();
+
+	SetConsoleColor(ConsoleColor::Red);
+
+	std::cout << "Edge anti-aliasing " << std::boolalpha << m_EdgeAntiAliasingEnabled << " (" << m_EdgeSampleCount << " extra samples per edge pixel)" << std::endl;
+
+	SetConsoleColor(ConsoleColor::Default);
+}
+
+void dae::Renderer::ToggleReprojection()
+{
+	m_ReprojectionEnabled = !m_ReprojectionEnabled;
+	m_ArePrimarySamplesValid = false;
+
+	SetConsoleColor(ConsoleColor::Red);
+
+	std::cout << "Temporal reprojection " << std::boolalpha << m_ReprojectionEnabled << std::endl;
+
+	SetConsoleColor(ConsoleColor::Default);
+}
+
+void dae::Renderer::ToggleDirtyRegions()
+{
+	m_DirtyRegionsEnabled = !m_DirtyRegionsEnabled;
+	m_ArePrimarySamplesValid = false;
+
+	SetConsoleColor(ConsoleColor::Red);
+
+	std::cout << "Dirty regions " << std::boolalpha << m_DirtyRegionsEnabled << std::endl;
+
+	SetConsoleColor(ConsoleColor::Default);
+}
+
+void dae::Renderer::ToggleWavefront()
+{
+	m_WavefrontEnabled = !m_WavefrontEnabled;
+
+	SetConsoleColor(ConsoleColor::Red);
+
+	std::cout << "Wavefront rendering " << std::boolalpha << m_WavefrontEnabled << std::endl;
+
+	SetConsoleColor(ConsoleColor::Default);
+}
+
+void dae::Renderer::ToggleRayBinning()
+{
+	m_RayBinningEnabled = !m_RayBinningEnabled;
+
+	SetConsoleColor(ConsoleColor::Red);
+
+	std::cout << "Shadow ray binning " << std::boolalpha << m_RayBinningEnabled << std::endl;
 
-	SetConsoleTextAttribute(hConsole, 0x07);
+	SetConsoleColor(ConsoleColor::Default);
 }
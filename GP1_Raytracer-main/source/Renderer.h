@@ -1,22 +1,27 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
 #include "DataTypes.h"
 #include "Material.h"
 #include "Camera.h"
-
-struct SDL_Window;
-struct SDL_Surface;
-struct ColorRGB;
+#include "ThreadPool.h"
+#include "Tonemapper.h"
 
 namespace dae
 {
 	class Scene;
+	struct WavefrontQueues;
 
 	class Renderer final
 	{
 	public:
-		Renderer(SDL_Window* pWindow);
+		//Renders into its own framebuffer, presenting it (window, file) is up to the caller
+		Renderer(uint32_t width, uint32_t height);
 		~Renderer() = default;
 
 		Renderer(const Renderer&) = delete;
@@ -24,21 +29,285 @@ namespace dae
 		Renderer& operator=(const Renderer&) = delete;
 		Renderer& operator=(Renderer&&) noexcept = delete;
 
-		void Render(Scene* pScene) const;
-		void RenderPixel(Scene* pScene, uint32_t pixelIndex, float fov, float aspectRatio, const Matrix cameraToWorld, const Vector3 camerOrigin, std::vector<dae::Material*>& materials, std::vector<dae::Light>& lights) const;
-		bool SaveBufferToImage() const;
+		//Adds one sample to every pixel that has not converged yet, starts over when the camera or the scene changed
+		void Render(Scene* pScene);
+		//occluders holds the last shadow ray blocker per light, see Scene::DoesHit
+		void RenderPixel(Scene* pScene, uint32_t pixelIndex, float fov, float aspectRatio, const Matrix cameraToWorld, const Vector3 camerOrigin, const std::vector<dae::MaterialData>& materials, std::vector<dae::Light>& lights, std::vector<Occluder>& occluders) const;
+		//Renders one screen tile of m_TileSize x m_TileSize pixels, the unit of work handed to the thread pool
+		void RenderTile(Scene* pScene, uint32_t tileIndex, uint32_t tileCountX, float fov, float aspectRatio, const Matrix& cameraToWorld, const Vector3& cameraOrigin, const std::vector<dae::MaterialData>& materials, std::vector<dae::Light>& lights) const;
+		//Renders one tile as a wavefront: every stage (camera rays, closest hits, shadow rays, any hits, shading) runs over the
+		//whole tile before the next one starts, passing structure of arrays queues along. Same image as RenderTile
+		void RenderTileWavefront(Scene* pScene, uint32_t tileIndex, uint32_t tileCountX, float fov, float aspectRatio, const Matrix& cameraToWorld, const Vector3& cameraOrigin, const std::vector<dae::MaterialData>& materials, std::vector<dae::Light>& lights) const;
+		//Renders the 4x4 pixels starting at (x, y), their primary rays are traced together as one packet.
+		//lightList is scratch for the lights that can reach the packet's hits
+		void RenderPacket(Scene* pScene, uint32_t x, uint32_t y, float fov, float aspectRatio, const Matrix& cameraToWorld, const Vector3& cameraOrigin, const std::vector<dae::MaterialData>& materials, std::vector<dae::Light>& lights, std::vector<Occluder>& occluders, std::vector<uint32_t>& lightList) const;
+		//Adds the edge samples to the edge pixels of one tile, only valid once every pixel of the image has its first sample
+		void RefineEdges(Scene* pScene, uint32_t tileIndex, uint32_t tileCountX, float fov, float aspectRatio, const Matrix& cameraToWorld, const Vector3& cameraOrigin, const std::vector<dae::MaterialData>& materials, std::vector<dae::Light>& lights) const;
+		//Writes the framebuffer as .ppm when the path ends in it, as .bmp otherwise. .pfm writes the linear radiance instead,
+		//before tonemapping. Returns true on success
+		bool SaveBufferToImage(const std::string& path = "RayTracing_Buffer.bmp") const;
+		//The same for pixels at the output size that are not the renderer's own anymore, e.g. a frame SwapPixels handed over
+		bool SaveBufferToImage(const uint32_t* pPixels, const std::string& path = "RayTracing_Buffer.bmp") const;
+
+		//Last rendered frame at the output size, 0xAARRGGBB per pixel, row by row from the top
+		const uint32_t* GetPixels() const { return IsUpscaling() ? m_OutputPixels.data() : m_Pixels.data(); }
+		//Hands the last frame over without copying: pixels gets it, its old storage becomes what the next Render writes to.
+		//GetPixels is meaningless until then
+		void SwapPixels(std::vector<uint32_t>& pixels);
+		int GetWidth() const { return m_OutputWidth; }
+		int GetHeight() const { return m_OutputHeight; }
+
+		//Dynamic resolution: the image is traced at scale times the output size and scaled up bilinearly.
+		//Clamped to [MinRenderScale, 1], a different size starts the accumulation over
+		void SetRenderScale(float scale);
+		float GetRenderScale() const { return m_RenderScale; }
+		int GetRenderWidth() const { return m_Width; }
+		int GetRenderHeight() const { return m_Height; }
+		static constexpr float MinRenderScale{ .125f };
+		//True when the last Render saw the camera move or zoom
+		bool HasCameraMoved() const { return m_HasCameraMoved; }
+
+		//The frame is rendered as linear radiance and tonemapped once it is complete, see Tonemapper. None of these
+		//settings trace anything again, the next Render resolves the same samples with them
+		void SetExposure(float stops);
+		float GetExposure() const { return m_Tonemapper.GetExposure(); }
+		void SetTonemapCurve(Tonemapper::Curve curve) { m_Tonemapper.SetCurve(curve); }
+		void CycleTonemapCurve();
+		void SetSRGB(bool isSRGB) { m_Tonemapper.SetSRGB(isSRGB); }
+		void ToggleSRGB();
 
 		void CycleLigntingMode();
 		void ToggleShadows();
+		void TogglePacketTracing();
+		void ToggleWavefront();
+		void ToggleRayBinning();
+		void ToggleAccumulation();
+		void ToggleEdgeAntiAliasing();
+		void ToggleReprojection();
+		void ToggleDirtyRegions();
+		//Fast-math shading: approximate reciprocal square roots, reciprocals and pow in the BRDFs and the radiance, see
+		//FastMath. Shadow rays stay exact, a grazing one could flip between hit and miss. See CompareFastMath for the error
+		void ToggleFastMath();
+		bool IsFastMathEnabled() const { return m_FastMathEnabled; }
+		//Renders full frames of the scene with every lighting mode, with and without shadows, and prints the time each
+		//shading variant takes. Leaves the mode and shadow setting as they were
+		void PrintShadingBenchmark(Scene* pScene);
+
+		//How far a fast-math frame is from the exact one, in 8 bit levels per color channel, and what each took
+		struct FastMathError
+		{
+			//largest difference fast math may make to a channel of a pixel, and to the average channel
+			static constexpr uint32_t MaxChannelError{ 2 };
+			static constexpr double MaxMeanChannelError{ .01 };
+
+			uint32_t maxChannelError{};
+			double meanChannelError{};
+			uint32_t differingPixelCount{};
+			double exactMs{};
+			double fastMs{};
+
+			bool IsWithinBounds() const { return maxChannelError <= MaxChannelError && meanChannelError <= MaxMeanChannelError; }
+		};
+		//Renders one frame of the scene exactly and one with fast math, best of a few runs each, and compares them.
+		//Leaves the fast-math setting as it was
+		FastMathError CompareFastMath(Scene* pScene);
+
+		//Throws away the accumulated samples, needed after changes the renderer cannot see itself
+		void ResetAccumulation() { m_SampleIndex = 0; }
+		//True when the last Render left no pixel that still wants samples
+		bool HasConverged() const { return m_UnconvergedPixelCount == 0; }
+		uint32_t GetSampleIndex() const { return m_SampleIndex; }
+		//Samples a pixel gets at most before it counts as converged
+		void SetMaxSamples(uint32_t maxSamples) { m_MaxSamples = std::max(maxSamples, 1u); }
+		//A pixel stops once the standard error of its mean luminance drops below this, 0 only stops at the max sample count
+		void SetConvergenceThreshold(float threshold) { m_ConvergenceThreshold = threshold; }
+
+		//Edge anti-aliasing: after the first sample of a fresh image, pixels whose neighbours differ in material, depth or
+		//luminance get this many extra sub-pixel rays. 0 turns it off, anything else turns it on
+		void SetEdgeSampleCount(uint32_t sampleCount) { m_EdgeSampleCount = sampleCount; m_EdgeAntiAliasingEnabled = sampleCount > 0; }
+		uint32_t GetEdgeSampleCount() const { return m_EdgeSampleCount; }
+		//Luminance difference and relative depth difference that count as an edge
+		void SetEdgeThreshold(float threshold) { m_EdgeThreshold = threshold; }
+		//Many-light sampling: once a scene has more lights than this, every hit traces this many shadow rays towards lights
+		//picked from the scene's light tree, weighted so the average stays the same. 0 always traces every light
+		void SetLightSampleCount(uint32_t sampleCount) { m_LightSampleCount = sampleCount; }
+		uint32_t GetLightSampleCount() const { return m_LightSampleCount; }
+		//Light culling: when every light is traced, a point light is skipped for the hits where its radiance stays below
+		//this in every channel, and a block of pixels only goes over the lights that can reach the bounds of its hits. 0 disables it
+		void SetLightCutoff(float cutoff) { m_LightCutoff = cutoff; }
+		float GetLightCutoff() const { return m_LightCutoff; }
+		//Pixels refined by the last Render, each got GetEdgeSampleCount extra rays
+		uint32_t GetEdgePixelCount() const { return m_EdgePixelCount; }
+		//Pixels the last Render took over from the previous frame instead of tracing them, reprojected or left untouched by moving geometry
+		uint32_t GetReusedPixelCount() const { return m_ReusedPixelCount; }
+		//Shadow rays the last Render traced through the wavefront path and the BVH nodes they entered, the fewer nodes per
+		//ray the more coherent they were
+		uint64_t GetShadowRayCount() const { return m_ShadowRayCount; }
+		uint64_t GetShadowNodeCount() const { return m_ShadowNodeCount; }
+
+		//Threads rendering a frame, including the calling one. 0 uses every hardware thread
+		void SetThreadCount(uint32_t threadCount);
+		uint32_t GetThreadCount() const { return m_pThreadPool->GetThreadCount(); }
+		//Side of the square screen tiles in pixels, rounded up to a whole number of ray packets
+		void SetTileSize(uint32_t tileSize);
+		uint32_t GetTileSize() const { return m_TileSize; }
 
 	private:
-		SDL_Window* m_pWindow{};
+		//x and y are in pixels, measured from the top left corner of the image
+		Vector3 GetViewDirection(float x, float y, float fov, float aspectRatio, const Matrix& cameraToWorld) const;
+		void GetTileBounds(uint32_t tileIndex, uint32_t tileCountX, uint32_t& startX, uint32_t& startY, uint32_t& endX, uint32_t& endY) const;
+		void CountUnconvergedPixels(uint32_t tileIndex, uint32_t tileCountX) const;
+		bool IsEdgePixel(uint32_t px, uint32_t py) const;
+		bool IsPixelConverged(uint32_t pixelIndex) const;
+		//the first sample after a reset overwrites whatever the pixel held, so every pixel needs it
+		bool NeedsSample(uint32_t pixelIndex) const { return m_SampleIndex == 0 ? !IsPixelReused(pixelIndex) : !IsPixelConverged(pixelIndex); }
+		//Sub-pixel position of the next sample, every pixel walks its own Halton sequence so reused pixels continue where they were
+		void GetSampleOffset(uint32_t pixelIndex, float& offsetX, float& offsetY) const;
+		//isFirstSample overwrites what the pixel held before
+		void AccumulateSample(uint32_t pixelIndex, const ColorRGB& color, bool isFirstSample) const;
+		void StorePrimarySample(uint32_t pixelIndex, const HitRecord& closestHit, const ColorRGB& color) const;
+		//Scatters last frame's primary hits into the new view, see m_ReprojectedSamples
+		void ReprojectPrimarySamples(const Matrix& cameraToWorld, const Vector3& cameraOrigin, float fov, float aspectRatio);
+		//Uses the reprojected samples of a tile for its first sample, the pixels without a trustworthy one are left for tracing
+		void ApplyReprojectedSamples(uint32_t tileIndex, uint32_t tileCountX) const;
+		//Keeps the pixels of a tile that moving geometry cannot have changed, the camera held still
+		void KeepUnchangedPixels(uint32_t tileIndex, uint32_t tileCountX) const;
+		bool IsPixelReused(uint32_t pixelIndex) const { return (m_IsReprojecting || m_IsKeepingUnchangedPixels) && m_IsPixelReused[pixelIndex]; }
+		//Screen regions the changed bounds of the scene and their shadows can reach, see m_ChangeRegions
+		void BuildChangeRegions(const Scene* pScene, const std::vector<dae::Light>& lights, const Matrix& cameraToWorld, const Vector3& cameraOrigin, float fov, float aspectRatio);
+		void MarkChangedPixels(uint32_t tileIndex, uint32_t tileCountX, const std::vector<dae::Light>& lights) const;
+		//Pixels next to a changed one are redrawn as well, their jittered samples reach into it
+		bool IsNearChangedPixel(uint32_t px, uint32_t py) const;
+		bool IsUpscaling() const { return m_Width != m_OutputWidth || m_Height != m_OutputHeight; }
+		//Tonemaps one row of the accumulated radiance into m_Pixels
+		void ResolveRow(uint32_t y) const;
+		void UpscaleRow(uint32_t y) const;
+		//Calls the ShadePixel instantiation Render picked for the current lighting mode and shadow setting
+		ColorRGB ShadePixel(Scene* pScene, const Ray& viewRay, const HitRecord& closestHit, uint32_t seed, const std::vector<uint32_t>& lightList, const std::vector<dae::MaterialData>& materials, std::vector<dae::Light>& lights, std::vector<Occluder>& occluders) const
+		{
+			return (this->*m_pShadePixel)(pScene, viewRay, closestHit, seed, lightList, materials, lights, occluders);
+		}
 
-		SDL_Surface* m_pBuffer{};
-		uint32_t* m_pBufferPixels{};
+		bool IsSamplingLights(size_t lightCount) const { return m_LightSampleCount > 0 && lightCount > m_LightSampleCount; }
+		bool IsInLightRange(uint32_t light, const Vector3& point) const { return (point - m_LightOrigins[light]).SqrMagnitude() <= m_LightRadiiSqr[light]; }
+		//Fills lightList, in light order, with the lights whose range overlaps the box
+		void CullLights(const Vector3& minAABB, const Vector3& maxAABB, std::vector<uint32_t>& lightList) const;
+		//Random seed of the sample a pixel takes next, a pixel's samples all pick different lights
+		uint32_t GetLightSeed(uint32_t pixelIndex, bool isFirstSample) const;
+		/**
+		 * \brief Picks a light for one shadow ray of a hit
+		 * \param weight set to what the light's contribution has to be scaled by, 0 when no light can reach the hit
+		 * \return index into the lights, LightTree::InvalidLight when no light can reach the hit
+		 */
+		uint32_t SampleLight(Scene* pScene, const Vector3& hitPlusOffset, const Vector3& normal, uint32_t seed, uint32_t sample, float& weight) const;
 
+		//Wavefront stages, each one consumes the queues of the one before
+		void GenerateCameraRays(uint32_t tileIndex, uint32_t tileCountX, float fov, float aspectRatio, const Matrix& cameraToWorld, WavefrontQueues& queues) const;
+		//misses are finished right away, only hits go on to the shadow and shading stages
+		void TraceCameraRays(Scene* pScene, const Vector3& cameraOrigin, WavefrontQueues& queues) const;
+		void GenerateShadowRays(Scene* pScene, const std::vector<dae::Light>& lights, WavefrontQueues& queues) const;
+		//reorders the shadow rays of every slot by direction octant, then by the Morton cell of their hit
+		void BinShadowRays(WavefrontQueues& queues) const;
+		//stable reorder of every slot's rays by light, sampled lights differ from hit to hit and packets need one origin
+		void GroupShadowRaysByLight(uint32_t lightCount, WavefrontQueues& queues) const;
+		void TraceShadowRays(Scene* pScene, const std::vector<dae::Light>& lights, WavefrontQueues& queues) const;
+		void ShadeHits(const std::vector<dae::MaterialData>& materials, std::vector<dae::Light>& lights, WavefrontQueues& queues) const
+		{
+			(this->*m_pShadeHits)(materials, lights, queues);
+		}
+
+		//traced size, every per pixel buffer below has this many entries
 		int m_Width{};
 		int m_Height{};
+		int m_OutputWidth{};
+		int m_OutputHeight{};
+		float m_RenderScale{ 1.f };
+
+		//8 bit image of m_SampleSums, the tiles never write it, ResolveRow does once they all finished
+		mutable std::vector<uint32_t> m_Pixels{};
+		//m_Pixels scaled up to the output size, only used below full resolution
+		mutable std::vector<uint32_t> m_OutputPixels{};
+
+		//Progressive accumulation: running sums per pixel, kept for as long as the camera and the scene hold still.
+		//m_SampleSums is the HDR framebuffer, linear radiance written concurrently by the tiles, every pixel by one of them.
+		//The luminance sums are of the clamped samples, see GetDisplayLuminance
+		mutable std::vector<ColorRGB> m_SampleSums{};
+		mutable std::vector<float> m_LuminanceSums{};
+		mutable std::vector<float> m_LuminanceSquareSums{};
+		mutable std::vector<uint32_t> m_SampleCounts{};
+		mutable std::atomic<uint32_t> m_UnconvergedPixelCount{};
+
+		//samples before the variance estimate is trusted
+		static constexpr uint32_t MinConvergenceSamples{ 8 };
+
+		//What the center ray of every pixel saw, edge detection compares it between neighbours and reprojection moves it to the next view
+		struct PrimarySample
+		{
+			Vector3 position{};
+			float depth{ FLT_MAX }; //FLT_MAX when the ray missed
+			float luminance{};
+			uint16_t age{}; //frames since it was traced
+			unsigned char materialIndex{};
+		};
+		mutable std::vector<PrimarySample> m_PrimarySamples{};
+		bool m_ArePrimarySamplesValid{ false };
+		mutable std::atomic<uint32_t> m_EdgePixelCount{};
+		uint32_t m_EdgeSampleCount{ 8 };
+		float m_EdgeThreshold{ .1f };
+		bool m_EdgeAntiAliasingEnabled{ false };
+
+		//Temporal reprojection: when only the camera moved, last frame's hits are reused wherever they land in the new view.
+		//Holes, background seen through foreground holes and a rolling 1/RefreshPeriod of the screen get traced again
+		struct ReprojectedSample
+		{
+			ColorRGB color{};
+			float viewDepth{ FLT_MAX }; //along the camera's forward axis, FLT_MAX when nothing landed here
+			PrimarySample primary{};
+		};
+		std::vector<ReprojectedSample> m_ReprojectedSamples{};
+		mutable std::vector<uint8_t> m_IsPixelReused{}; //bytes, tiles write their pixels concurrently
+		mutable std::atomic<uint32_t> m_ReusedPixelCount{};
+		static constexpr uint32_t RefreshPeriod{ 16 };
+		uint32_t m_FrameIndex{};
+		bool m_IsReprojecting{ false };
+		bool m_ReprojectionEnabled{ true };
+
+		//Dirty regions: when the scene can say which bounds changed, only pixels that can see them or a shadow they cast
+		//are traced again. Lights and materials are assumed not to change
+		struct ChangeRegion
+		{
+			Vector3 minAABB{};
+			Vector3 maxAABB{};
+			int minX{}, minY{}, maxX{}, maxY{}; //inclusive pixel rect
+			uint32_t lightIndex{ NoLight }; //the box itself, or the shadow it casts from this light
+		};
+		static constexpr uint32_t NoLight{ UINT32_MAX };
+		std::vector<ChangeRegion> m_ChangeRegions{};
+		mutable std::vector<uint8_t> m_IsPixelChanged{};
+		bool m_HasMovedGeometry{ false };
+		bool m_IsKeepingUnchangedPixels{ false };
+		bool m_DirtyRegionsEnabled{ true };
+
+		//Pixel rect around everything in front of the camera that the points span, false when none of it is on screen
+		bool GetScreenRect(const Vector3* points, uint32_t pointCount, const Matrix& cameraToWorld, const Vector3& cameraOrigin, float fov, float aspectRatio, ChangeRegion& region) const;
+		//The hit a pixel would reuse: its own from last frame, or what got reprojected onto it
+		const PrimarySample& GetReusedSample(uint32_t pixelIndex) const { return m_IsReprojecting ? m_ReprojectedSamples[pixelIndex].primary : m_PrimarySamples[pixelIndex]; }
+
+		uint32_t m_SampleIndex{}; //0 overwrites the sums instead of adding to them
+		uint32_t m_MaxSamples{ 256 };
+		float m_ConvergenceThreshold{ 1.f / 512.f }; //half an 8 bit step
+		bool m_AccumulationEnabled{ true };
+
+		const Scene* m_pLastScene{};
+		uint32_t m_LastSceneVersion{};
+		Matrix m_LastCameraToWorld{};
+		float m_LastFov{};
+		bool m_HasCameraMoved{ false };
+
+		Tonemapper m_Tonemapper{};
+
+		std::unique_ptr<ThreadPool> m_pThreadPool{};
+		uint32_t m_TileSize{ 16 };
 
 		enum class LightingMode
 		{
@@ -49,6 +318,47 @@ namespace dae
 		};
 
 		LightingMode m_CurrentLightingMode{ LightingMode::Combined };
+
+		//The shading kernels are instantiated per lighting mode, shadow setting and fast-math setting, so their per light
+		//loops carry no branches on any of them. Render picks the instantiations once per frame.
+		//seed picks the lights when there are too many to trace them all, see GetLightSeed. Otherwise the lights of lightList
+		//are traced, in its order, as far as they reach the hit
+		template<LightingMode Mode, bool HasShadows, bool IsFastMath>
+		ColorRGB ShadePixel(Scene* pScene, const Ray& viewRay, const HitRecord& closestHit, uint32_t seed, const std::vector<uint32_t>& lightList, const std::vector<dae::MaterialData>& materials, std::vector<dae::Light>& lights, std::vector<Occluder>& occluders) const;
+		//shadows are left out by not tracing the shadow rays, every ray is visible then
+		template<LightingMode Mode, bool IsFastMath>
+		void ShadeHits(const std::vector<dae::MaterialData>& materials, std::vector<dae::Light>& lights, WavefrontQueues& queues) const;
+		//What one unblocked light adds to a hit, l points from the light to the hit and v from the hit to the camera.
+		//brdf(normal, toLight, toCamera) is the hit material's, see MaterialShading
+		template<LightingMode Mode, bool IsFastMath, typename BRDFFunction>
+		ColorRGB ShadeLight(const HitRecord& closestHit, const Light& light, const Vector3& l, const Vector3& v, const BRDFFunction& brdf) const;
+
+		using ShadePixelFunction = ColorRGB(Renderer::*)(Scene*, const Ray&, const HitRecord&, uint32_t, const std::vector<uint32_t>&, const std::vector<dae::MaterialData>&, std::vector<dae::Light>&, std::vector<Occluder>&) const;
+		using ShadeHitsFunction = void(Renderer::*)(const std::vector<dae::MaterialData>&, std::vector<dae::Light>&, WavefrontQueues&) const;
+		static ShadePixelFunction GetShadePixelFunction(LightingMode mode, bool hasShadows, bool isFastMath);
+		static ShadeHitsFunction GetShadeHitsFunction(LightingMode mode, bool isFastMath);
+		static const char* GetLightingModeName(LightingMode mode);
+		ShadePixelFunction m_pShadePixel{ GetShadePixelFunction(LightingMode::Combined, true, false) };
+		ShadeHitsFunction m_pShadeHits{ GetShadeHitsFunction(LightingMode::Combined, false) };
+
+		uint32_t m_LightSampleCount{ 4 };
+		float m_LightCutoff{ 1.f / 1024.f };
+		//per frame: where each light sits and how far it reaches, and the indices of every light for callers without a list
+		std::vector<Vector3> m_LightOrigins{};
+		std::vector<float> m_LightRadiiSqr{};
+		std::vector<uint32_t> m_AllLights{};
+		//material indices ordered by type, for batched shading
+		std::vector<uint32_t> m_MaterialOrder{};
 		bool m_ShadowsEnabled{ true };
+		bool m_FastMathEnabled{ false };
+		bool m_PacketTracingEnabled{ true };
+		bool m_WavefrontEnabled{ false };
+		bool m_RayBinningEnabled{ false };
+		//shadow rays are binned into 8 direction octants times BinGridSize^3 Morton cells over the hits of a tile
+		static constexpr uint32_t BinGridSize{ 4 };
+		static constexpr uint32_t BinCellCount{ BinGridSize * BinGridSize * BinGridSize };
+		static constexpr uint32_t BinCount{ 8 * BinCellCount };
+		mutable std::atomic<uint64_t> m_ShadowRayCount{};
+		mutable std::atomic<uint64_t> m_ShadowNodeCount{};
 	};
 }
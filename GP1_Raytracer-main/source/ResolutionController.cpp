@@ -0,0 +1,68 @@
+#include "ResolutionController.h"
+#include "Renderer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace dae
+{
+	ResolutionController::ResolutionController(float targetFrameRate)
+	{
+		SetTargetFrameRate(targetFrameRate);
+	}
+
+	void ResolutionController::SetTargetFrameRate(float targetFrameRate)
+	{
+		m_TargetFrameTime = targetFrameRate > 0.f ? 1.f / targetFrameRate : 0.f;
+		m_MovingScale = 1.f;
+		if (m_TargetFrameTime == 0.f && m_Scale < 1.f) SetScale(1.f, "no target frame rate");
+	}
+
+	float ResolutionController::Update(float elapsedTime, bool isViewMoving)
+	{
+		if (m_TargetFrameTime == 0.f) return m_Scale;
+
+		if (!isViewMoving)
+		{
+			m_SettledTime += elapsedTime;
+			if (m_Scale < 1.f && m_SettledTime >= SettleDelay) SetScale(1.f, "view settled");
+			return m_Scale;
+		}
+
+		//a full resolution frame of a heavy scene can take seconds, go straight back to what kept up last time
+		if (m_SettledTime > 0.f && m_Scale != m_MovingScale)
+		{
+			m_SettledTime = 0.f;
+			SetScale(m_MovingScale, "view started moving");
+			return m_Scale;
+		}
+		m_SettledTime = 0.f;
+
+		++m_FramesAtScale;
+		if (m_FramesAtScale == 1) return m_Scale;
+		m_AverageFrameTime = m_FramesAtScale == 2 ? elapsedTime : m_AverageFrameTime + (elapsedTime - m_AverageFrameTime) * .3f;
+		if (m_FramesAtScale < MinFramesPerScale) return m_Scale;
+
+		//hysteresis, noise around the target should not flip between two scales
+		const float ratio{ m_TargetFrameTime / m_AverageFrameTime };
+		if (ratio >= 1.f - Tolerance && ratio <= 1.f + 2.f * Tolerance) return m_Scale;
+
+		float scale{ std::round(m_Scale * std::sqrt(ratio) / ScaleStep) * ScaleStep };
+		scale = std::clamp(scale, Renderer::MinRenderScale, 1.f);
+		if (scale != m_Scale) SetScale(scale, ratio < 1.f ? "too slow" : "headroom");
+		m_MovingScale = m_Scale;
+		return m_Scale;
+	}
+
+	void ResolutionController::SetScale(float scale, const char* reason)
+	{
+		std::cout << "Render scale " << m_Scale << " -> " << scale << " (" << reason;
+		if (m_FramesAtScale > 1) std::cout << ", " << m_AverageFrameTime * 1000.f << " ms per frame";
+		if (m_TargetFrameTime > 0.f) std::cout << ", target " << m_TargetFrameTime * 1000.f << " ms";
+		std::cout << ')' << std::endl;
+
+		m_Scale = scale;
+		m_FramesAtScale = 0;
+	}
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+
+namespace dae
+{
+	//Picks the render scale that holds a target frame rate while the view moves, and full resolution once it settled.
+	//Frame time is taken to grow with the pixel count, so the scale follows the square root of the time ratio
+	class ResolutionController final
+	{
+	public:
+		//targetFrameRate 0 keeps full resolution
+		explicit ResolutionController(float targetFrameRate = 30.f);
+		~ResolutionController() = default;
+
+		ResolutionController(const ResolutionController&) = delete;
+		ResolutionController(ResolutionController&&) noexcept = delete;
+		ResolutionController& operator=(const ResolutionController&) = delete;
+		ResolutionController& operator=(ResolutionController&&) noexcept = delete;
+
+		/**
+		 * \brief Feeds the controller one frame and returns the render scale for the next one, decisions are logged
+		 * \param elapsedTime seconds the last frame took, Timer::GetElapsed
+		 * \param isViewMoving whether the camera moved in the last frame
+		 */
+		float Update(float elapsedTime, bool isViewMoving);
+
+		float GetScale() const { return m_Scale; }
+		void SetTargetFrameRate(float targetFrameRate);
+
+	private:
+		void SetScale(float scale, const char* reason);
+
+		//a scale has to run this many frames before its time is judged. The first one after a switch traces every pixel
+		//and does not count
+		static constexpr uint32_t MinFramesPerScale{ 5 };
+		//slower than the target by this fraction lowers the resolution, faster by twice as much raises it again
+		static constexpr float Tolerance{ .15f };
+		//scales snap to multiples of this, so the image does not creep by a few pixels every other frame
+		static constexpr float ScaleStep{ 1.f / 16.f };
+		//seconds without camera movement before full resolution comes back
+		static constexpr float SettleDelay{ .25f };
+
+		float m_TargetFrameTime{};
+		float m_Scale{ 1.f };
+		//what the view last moved at, picked up again as soon as it moves after settling
+		float m_MovingScale{ 1.f };
+		float m_AverageFrameTime{};
+		uint32_t m_FramesAtScale{};
+		float m_SettledTime{};
+	};
+}
@@ -1,13 +1,18 @@
 #include "Scene.h"
 #include "Utils.h"
 #include "Material.h"
+#include "RayPacket.h"
+#include "Timer.h"
+
+#include <iostream>
 
 namespace dae {
 
 #pragma region Base Scene
 	//Initialize Scene with Default Solid Color Material (RED)
 	Scene::Scene():
-		m_Materials({ new Material_SolidColor({1,0,0})})
+		m_Materials({ new Material_SolidColor({1,0,0})}),
+		m_MaterialData({ m_Materials[0]->GetData() })
 	{
 		m_SphereGeometries.reserve(32);
 		m_PlaneGeometries.reserve(32);
@@ -61,57 +66,310 @@ namespace dae {
 		}
 
 		// triangleMeshes
-		for (int idx{}; idx < m_TriangleMeshGeometries.size(); ++idx)
+		const Vector3 inverseDirection{ 1.f / ray.direction.x, 1.f / ray.direction.y, 1.f / ray.direction.z };
+		float maxDistance{ std::min(ray.max, closestHit.t) };
+		const std::vector<uint32_t>& instanceIndices{ m_TopLevelBVH.GetPrimitiveIndices() };
+
+		GeometryUtils::TraverseBVH(m_TopLevelBVH.GetNodes(), ray, inverseDirection, maxDistance, [&](const BVHNode& node)
+			{
+				for (uint32_t i{}; i < node.primitiveCount; ++i)
+				{
+					HitRecord tempHit{};
+					if (GeometryUtils::HitTest_TriangleMesh(m_TriangleMeshGeometries[instanceIndices[node.leftFirst + i]], ray, tempHit) && tempHit.t < closestHit.t)
+					{
+						closestHit = tempHit;
+						maxDistance = std::min(maxDistance, tempHit.t);
+					}
+				}
+				return false;
+			});
+	}
+
+	void Scene::GetClosestHits(const RayPacket& packet, HitRecord* closestHits) const
+	{
+		//rays heading into different octants share little of the traversal, trace them one by one.
+		//The same goes for sparse packets (converged or reprojected neighbours), a packet test costs as much for one lane as for all
+		if (packet.GetActiveCount() <= RayPacket::Size / 4 || !packet.IsCoherent())
 		{
-			HitRecord tempHit{};
-			if (GeometryUtils::HitTest_TriangleMesh(m_TriangleMeshGeometries[idx], ray, tempHit) && tempHit.t < closestHit.t)
+			for (uint32_t lane{}; lane < RayPacket::Size; ++lane)
 			{
-				closestHit = tempHit;
+				if (packet.IsActive(lane)) GetClosestHit(packet.GetRay(lane), closestHits[lane]);
 			}
+			return;
+		}
+
+		// spheres
+		for (const Sphere& sphere : m_SphereGeometries)
+		{
+			PacketUtils::HitTest_Sphere(sphere, packet, closestHits);
 		}
+
+		// planes
+		for (const Plane& plane : m_PlaneGeometries)
+		{
+			PacketUtils::HitTest_Plane(plane, packet, closestHits);
+		}
+
+		// triangles
+		for (uint32_t lane{}; lane < RayPacket::Size; ++lane)
+		{
+			if (!packet.IsActive(lane)) continue;
+
+			const Ray ray{ packet.GetRay(lane) };
+			for (const Triangle& triangle : m_Triangles)
+			{
+				HitRecord tempHit{};
+				if (GeometryUtils::HitTest_Triangle(triangle, ray, tempHit) && tempHit.t < closestHits[lane].t)
+				{
+					closestHits[lane] = tempHit;
+				}
+			}
+		}
+
+		// triangleMeshes
+		PacketUtils::HitTest_TriangleMeshes(m_TopLevelBVH, m_TriangleMeshGeometries, packet, closestHits);
 	}
 
 	bool Scene::DoesHit(const Ray& ray) const
+	{
+		Occluder occluder{};
+		return DoesHit(ray, occluder);
+	}
+
+	bool Scene::DoesHit(const Ray& ray, Occluder& lastOccluder) const
 	{
 		//todo W3
+		if (IsOccludedBy(ray, lastOccluder)) return true;
+
+		return DoesHitPrimitives(ray, lastOccluder) || DoesHitTriangleMeshes(ray, lastOccluder);
+	}
+
+	uint32_t Scene::GetOccludedLanes(const RayPacket& packet, const float* maxDistances, Occluder& lastOccluder) const
+	{
+		//the cached occluder and the few loose primitives are tested lane by lane, only the meshes are worth a packet traversal
+		RayPacket remaining{ packet };
+		uint32_t occludedMask{};
+		for (uint32_t lane{}; lane < RayPacket::Size; ++lane)
+		{
+			if (!packet.IsActive(lane)) continue;
+
+			const Ray ray{ packet.origin, { packet.directionX[lane], packet.directionY[lane], packet.directionZ[lane] }, packet.min, maxDistances[lane] };
+			if (IsOccludedBy(ray, lastOccluder) || DoesHitPrimitives(ray, lastOccluder)) occludedMask |= 1u << lane;
+		}
+		remaining.activeMask &= ~occludedMask;
+		if (remaining.activeMask == 0) return occludedMask;
+
+		if (remaining.GetActiveCount() <= RayPacket::Size / 4 || !remaining.IsCoherent())
+		{
+			for (uint32_t lane{}; lane < RayPacket::Size; ++lane)
+			{
+				if (!remaining.IsActive(lane)) continue;
+
+				const Ray ray{ packet.origin, { packet.directionX[lane], packet.directionY[lane], packet.directionZ[lane] }, packet.min, maxDistances[lane] };
+				if (DoesHitTriangleMeshes(ray, lastOccluder)) occludedMask |= 1u << lane;
+			}
+			return occludedMask;
+		}
+
+		uint32_t occludingMesh{}, occludingTriangle{};
+		const uint32_t meshOccludedMask{ PacketUtils::DoesHit_TriangleMeshes(m_TopLevelBVH, m_TriangleMeshGeometries, remaining, maxDistances, occludingMesh, occludingTriangle) };
+		if (meshOccludedMask != 0) lastOccluder = { Occluder::Type::TriangleMesh, occludingMesh, occludingTriangle };
+		return occludedMask | meshOccludedMask;
+	}
 
+	bool Scene::DoesHitPrimitives(const Ray& ray, Occluder& lastOccluder) const
+	{
 		// spheres
-		for (int idx{}; idx < m_SphereGeometries.size(); ++idx)
+		for (uint32_t idx{}; idx < m_SphereGeometries.size(); ++idx)
 		{
 			if (GeometryUtils::HitTest_Sphere(m_SphereGeometries[idx], ray))
 			{
+				lastOccluder = { Occluder::Type::Sphere, idx };
 				return true;
 			}
 		}
 
 		// planes
-		for (int idx{}; idx < m_PlaneGeometries.size(); ++idx)
+		for (uint32_t idx{}; idx < m_PlaneGeometries.size(); ++idx)
 		{
 			if (GeometryUtils::HitTest_Plane(m_PlaneGeometries[idx], ray))
 			{
+				lastOccluder = { Occluder::Type::Plane, idx };
 				return true;
 			}
 		}
 
 		// triangles
-		for (int idx{}; idx < m_Triangles.size(); ++idx)
+		for (uint32_t idx{}; idx < m_Triangles.size(); ++idx)
 		{
 			if (GeometryUtils::HitTest_Triangle(m_Triangles[idx], ray))
 			{
+				lastOccluder = { Occluder::Type::Triangle, idx };
 				return true;
 			}
 		}
+		return false;
+	}
 
-		// triangleMeshes
-		for (int idx{}; idx < m_TriangleMeshGeometries.size(); ++idx)
+	bool Scene::DoesHitTriangleMeshes(const Ray& ray, Occluder& lastOccluder) const
+	{
+		// triangleMeshes, any hit ends the traversal
+		const Vector3 inverseDirection{ 1.f / ray.direction.x, 1.f / ray.direction.y, 1.f / ray.direction.z };
+		float maxDistance{ ray.max };
+		const std::vector<uint32_t>& instanceIndices{ m_TopLevelBVH.GetPrimitiveIndices() };
+		bool didHit{ false };
+
+		GeometryUtils::TraverseBVH(m_TopLevelBVH.GetNodes(), ray, inverseDirection, maxDistance, [&](const BVHNode& node)
+			{
+				for (uint32_t i{}; i < node.primitiveCount; ++i)
+				{
+					const uint32_t meshIndex{ instanceIndices[node.leftFirst + i] };
+					uint32_t triangle{};
+					if (GeometryUtils::DoesHit_TriangleMesh(m_TriangleMeshGeometries[meshIndex], ray, triangle))
+					{
+						lastOccluder = { Occluder::Type::TriangleMesh, meshIndex, triangle };
+						didHit = true;
+						return true;
+					}
+				}
+				return false;
+			});
+
+		//a miss keeps the old occluder, the next pixel may well be behind it again
+		return didHit;
+	}
+
+	bool Scene::IsOccludedBy(const Ray& ray, const Occluder& occluder) const
+	{
+		switch (occluder.type)
+		{
+		case Occluder::Type::Sphere:
+			return GeometryUtils::HitTest_Sphere(m_SphereGeometries[occluder.index], ray);
+		case Occluder::Type::Plane:
+			return GeometryUtils::HitTest_Plane(m_PlaneGeometries[occluder.index], ray);
+		case Occluder::Type::Triangle:
+			return GeometryUtils::HitTest_Triangle(m_Triangles[occluder.index], ray);
+		case Occluder::Type::TriangleMesh:
+			return GeometryUtils::DoesHit_MeshTriangle(m_TriangleMeshGeometries[occluder.index], ray, occluder.triangle);
+		default:
+			return false;
+		}
+	}
+
+	void Scene::UpdateTopLevelBVH()
+	{
+		//O(instances): only the world bounds of every mesh are needed, the bottom level trees stay untouched
+		std::vector<Vector3> minAABBs{};
+		std::vector<Vector3> maxAABBs{};
+		minAABBs.reserve(m_TriangleMeshGeometries.size());
+		maxAABBs.reserve(m_TriangleMeshGeometries.size());
+
+		//added or removed meshes cannot be described by moved bounds
+		const bool hasMeshCountChanged{ m_LastWorldTransforms.size() != m_TriangleMeshGeometries.size() };
+		m_LastWorldTransforms.resize(m_TriangleMeshGeometries.size());
+		m_LastMinAABBs.resize(m_TriangleMeshGeometries.size());
+		m_LastMaxAABBs.resize(m_TriangleMeshGeometries.size());
+
+		std::vector<Vector3> changedMinAABBs{};
+		std::vector<Vector3> changedMaxAABBs{};
+		for (size_t i{}; i < m_TriangleMeshGeometries.size(); ++i)
 		{
-			if (GeometryUtils::HitTest_TriangleMesh(m_TriangleMeshGeometries[idx], ray))
+			TriangleMesh& mesh{ m_TriangleMeshGeometries[i] };
+			minAABBs.emplace_back(mesh.transformedMinAABB);
+			maxAABBs.emplace_back(mesh.transformedMaxAABB);
+
+			if (mesh.hasShapeChanged || !(m_LastWorldTransforms[i] == mesh.worldTransform))
 			{
-				return true;
+				//whatever the mesh covered before and covers now looks different
+				changedMinAABBs.emplace_back(m_LastMinAABBs[i]);
+				changedMaxAABBs.emplace_back(m_LastMaxAABBs[i]);
+				changedMinAABBs.emplace_back(mesh.transformedMinAABB);
+				changedMaxAABBs.emplace_back(mesh.transformedMaxAABB);
+
+				m_LastWorldTransforms[i] = mesh.worldTransform;
+				m_LastMinAABBs[i] = mesh.transformedMinAABB;
+				m_LastMaxAABBs[i] = mesh.transformedMaxAABB;
+				mesh.hasShapeChanged = false;
 			}
 		}
 
-		return false;
+		m_TopLevelBVH.Build(minAABBs, maxAABBs);
+		//lights may move in Update as well, and even hundreds of them build faster than the instances
+		m_LightTree.Build(m_Lights);
+		if (changedMinAABBs.empty() && !hasMeshCountChanged) return;
+
+		m_ChangedMinAABBs = std::move(changedMinAABBs);
+		m_ChangedMaxAABBs = std::move(changedMaxAABBs);
+		m_ChangedBoundsBaseVersion = hasMeshCountChanged ? m_Version + 1 : m_Version;
+		++m_Version;
+	}
+
+	void Scene::PrintAccelerationStructureStats() const
+	{
+		for (size_t idx{}; idx < m_TriangleMeshGeometries.size(); ++idx)
+		{
+			const BVH& bvh{ m_TriangleMeshGeometries[idx].bvh };
+			std::cout << "BLAS mesh " << idx << ": " << bvh.GetPrimitiveCount() << " triangles, "
+				<< bvh.GetNodeCount() << " nodes, built in " << bvh.GetBuildTime() << " ms" << std::endl;
+		}
+
+		std::cout << "TLAS: " << m_TopLevelBVH.GetPrimitiveCount() << " instances, "
+			<< m_TopLevelBVH.GetNodeCount() << " nodes, built in " << m_TopLevelBVH.GetBuildTime() << " ms" << std::endl;
+	}
+
+	void Scene::PrintBVHUpdateBenchmark() const
+	{
+		constexpr int RUNS{ 20 };
+		std::cout << "BVH rebuild vs refit (average of " << RUNS << " runs)" << std::endl;
+
+		for (size_t idx{}; idx < m_TriangleMeshGeometries.size(); ++idx)
+		{
+			const TriangleMesh& mesh{ m_TriangleMeshGeometries[idx] };
+
+			//slightly moved copy of the vertices so the refit has real work to do
+			std::vector<Vector3> movedPositions{ mesh.positions };
+			for (size_t i{}; i < movedPositions.size(); ++i)
+			{
+				movedPositions[i] += Vector3{ sinf(float(i)), cosf(float(i)), sinf(float(i) * .5f) } * .01f;
+			}
+
+			const size_t triangleCount{ mesh.indices.size() / 3 };
+			for (size_t fraction : { 8, 4, 2, 1 })
+			{
+				const size_t subsetCount{ triangleCount / fraction };
+				if (subsetCount == 0) continue;
+
+				const std::vector<int> subsetIndices(mesh.indices.begin(), mesh.indices.begin() + subsetCount * 3);
+
+				BVH bvh{};
+				float buildTime{};
+				for (int run{}; run < RUNS; ++run)
+				{
+					bvh.Build(mesh.positions, subsetIndices);
+					buildTime += bvh.GetBuildTime();
+				}
+
+				float refitTime{};
+				for (int run{}; run < RUNS; ++run)
+				{
+					bvh.Refit(run % 2 == 0 ? movedPositions : mesh.positions, subsetIndices);
+					refitTime += bvh.GetRefitTime();
+				}
+				bvh.Refit(movedPositions, subsetIndices);
+
+				buildTime /= RUNS;
+				refitTime /= RUNS;
+				std::cout << "mesh " << idx << ", " << subsetCount << " triangles: rebuild " << buildTime << " ms, refit "
+					<< refitTime << " ms (x" << (refitTime > 0.f ? buildTime / refitTime : 0.f) << "), refit SAH ratio "
+					<< bvh.GetQualityRatio() << std::endl;
+			}
+		}
+	}
+
+	void Scene::ToggleMeshDeformation()
+	{
+		m_DeformMeshes = !m_DeformMeshes;
+		std::cout << "Mesh deformation " << std::boolalpha << m_DeformMeshes << std::endl;
 	}
 
 #pragma region Scene Helpers
@@ -174,6 +432,7 @@ namespace dae {
 	unsigned char Scene::AddMaterial(Material* pMaterial)
 	{
 		m_Materials.push_back(pMaterial);
+		m_MaterialData.push_back(pMaterial->GetData());
 		return static_cast<unsigned char>(m_Materials.size() - 1);
 	}
 #pragma endregion
@@ -385,6 +644,8 @@ namespace dae {
 		m_TriangleMeshGeometries[0].UpdateAABB();
 		m_TriangleMeshGeometries[0].UpdateTransforms();
 
+		m_RestPositions = m_TriangleMeshGeometries[0].positions;
+
 		AddPointLight(Vector3{ 0.f, 5.f, 5.f }, 50.f, ColorRGB{ 1.f, .61f, .45f }); //Backlight
 		AddPointLight(Vector3{ -2.5f, 5.f, -5.f }, 70.f, ColorRGB{ 1.f, .8f, .45f }); //Front Light Left
 		AddPointLight(Vector3{ 2.5f, 2.5f, -5.f }, 50.f, ColorRGB{ .34f, .47f, .68f });
@@ -393,6 +654,28 @@ namespace dae {
 	{
 		Scene::Update(pTimer);
 		const float rotationAngle{ (cos(pTimer->GetTotal() + 1) / 2.f * PI_2) + PI };
+
+		//optional sway of the vertices themselves, exercises the BVH refit path
+		TriangleMesh& bunny{ m_TriangleMeshGeometries[0] };
+		if (m_DeformMeshes)
+		{
+			const float time{ pTimer->GetTotal() };
+			for (size_t i{}; i < bunny.positions.size(); ++i)
+			{
+				const Vector3& restPosition{ m_RestPositions[i] };
+				const float sway{ sinf(time * 3.f + restPosition.y * 4.f) * .05f };
+				bunny.positions[i] = { restPosition.x + sway, restPosition.y, restPosition.z };
+			}
+			bunny.arePositionsDirty = true;
+			m_IsDeformed = true;
+		}
+		else if (m_IsDeformed)
+		{
+			bunny.positions = m_RestPositions;
+			bunny.arePositionsDirty = true;
+			m_IsDeformed = false;
+		}
+
 		for (int idx{}; idx < m_TriangleMeshGeometries.size(); ++idx)
 		{
 			m_TriangleMeshGeometries[idx].Rotate(0, rotationAngle, 0);
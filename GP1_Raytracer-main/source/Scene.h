@@ -5,15 +5,18 @@
 #include "Math.h"
 #include "DataTypes.h"
 #include "Camera.h"
+#include "LightTree.h"
 
 namespace dae
 {
 	//Forward Declarations
 	class Timer;
 	class Material;
+	struct MaterialData;
 	struct Plane;
 	struct Sphere;
 	struct Light;
+	struct RayPacket;
 
 	//Scene Base Class
 	class Scene
@@ -28,19 +31,45 @@ namespace dae
 		Scene& operator=(Scene&&) noexcept = delete;
 
 		virtual void Initialize() = 0;
-		virtual void Update(dae::Timer* pTimer)
-		{
-			m_Camera.Update(pTimer);
-		}
+		//Animates the scene. The camera is moved by whoever owns the input, see Camera::Update
+		virtual void Update(dae::Timer*) {}
 
 		Camera& GetCamera() { return m_Camera; }
 		void GetClosestHit(const Ray& ray, HitRecord& closestHit) const;
 		bool DoesHit(const Ray& ray) const;
+		//Any-hit query that tries lastOccluder first and replaces it with whatever blocked the ray.
+		//Only valid for one frame, the geometry it points at can change in Update
+		bool DoesHit(const Ray& ray, Occluder& lastOccluder) const;
+		//Closest hit for every active lane of the packet, closestHits holds RayPacket::Size records
+		void GetClosestHits(const RayPacket& packet, HitRecord* closestHits) const;
+		//Any-hit query for every active lane of the packet, lane i is limited to maxDistances[i]. Returns the mask of blocked lanes,
+		//lastOccluder is used and updated as in DoesHit
+		uint32_t GetOccludedLanes(const RayPacket& packet, const float* maxDistances, Occluder& lastOccluder) const;
+
+		//Rebuilds the top level BVH over the mesh instances and the light tree, call after the mesh transforms changed
+		void UpdateTopLevelBVH();
+		void PrintAccelerationStructureStats() const;
+		//Times a full rebuild against a refit of every mesh BVH at a few mesh sizes
+		void PrintBVHUpdateBenchmark() const;
+
+		void ToggleMeshDeformation();
+
+		//Changes whenever geometry moved since the previous UpdateTopLevelBVH, renderers keep accumulating samples while it stays the same
+		uint32_t GetVersion() const { return m_Version; }
+		//World bounds of the meshes that changed in the last version step, each one where it was and where it is now.
+		//They only describe the step from GetChangedBoundsBaseVersion to GetVersion, anything older needs a full redraw
+		const std::vector<Vector3>& GetChangedMinAABBs() const { return m_ChangedMinAABBs; }
+		const std::vector<Vector3>& GetChangedMaxAABBs() const { return m_ChangedMaxAABBs; }
+		uint32_t GetChangedBoundsBaseVersion() const { return m_ChangedBoundsBaseVersion; }
 
 		const std::vector<Plane>& GetPlaneGeometries() const { return m_PlaneGeometries; }
 		const std::vector<Sphere>& GetSphereGeometries() const { return m_SphereGeometries; }
 		const std::vector<Light>& GetLights() const { return m_Lights; }
-		const std::vector<Material*> GetMaterials() const { return m_Materials; }
+		//Hierarchy over GetLights for picking a few of many lights, as of the last UpdateTopLevelBVH
+		const LightTree& GetLightTree() const { return m_LightTree; }
+		const std::vector<Material*>& GetMaterials() const { return m_Materials; }
+		//GetMaterials as a flat table of their types and parameters, what the renderer shades with
+		const std::vector<MaterialData>& GetMaterialData() const { return m_MaterialData; }
 
 	protected:
 		std::string	sceneName;
@@ -51,7 +80,19 @@ namespace dae
 		std::vector<Triangle> m_Triangles{};
 		std::vector<Light> m_Lights{};
 		std::vector<Material*> m_Materials{};
+		std::vector<MaterialData> m_MaterialData{};
 
+		BVH m_TopLevelBVH{};
+		LightTree m_LightTree{};
+		bool m_DeformMeshes{ false };
+
+		uint32_t m_Version{};
+		std::vector<Matrix> m_LastWorldTransforms{};
+		std::vector<Vector3> m_LastMinAABBs{};
+		std::vector<Vector3> m_LastMaxAABBs{};
+		std::vector<Vector3> m_ChangedMinAABBs{};
+		std::vector<Vector3> m_ChangedMaxAABBs{};
+		uint32_t m_ChangedBoundsBaseVersion{};
 
 		Camera m_Camera{};
 
@@ -62,6 +103,12 @@ namespace dae
 		Light* AddPointLight(const Vector3& origin, float intensity, const ColorRGB& color);
 		Light* AddDirectionalLight(const Vector3& direction, float intensity, const ColorRGB& color);
 		unsigned char AddMaterial(Material* pMaterial);
+
+	private:
+		bool IsOccludedBy(const Ray& ray, const Occluder& occluder) const;
+		//the any-hit tests of DoesHit, split so packets can share the first part and trace the meshes together
+		bool DoesHitPrimitives(const Ray& ray, Occluder& lastOccluder) const;
+		bool DoesHitTriangleMeshes(const Ray& ray, Occluder& lastOccluder) const;
 	};
 
 	//+++++++++++++++++++++++++++++++++++++++++
@@ -144,6 +191,10 @@ namespace dae
 
 		void Initialize() override;
 		void Update(Timer* pTimer) override;
+
+	private:
+		std::vector<Vector3> m_RestPositions{};
+		bool m_IsDeformed{ false };
 	};
 
 	//+++++++++++++++++++++++++++++++++++++++++
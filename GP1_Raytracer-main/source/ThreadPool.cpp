@@ -0,0 +1,124 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+namespace dae
+{
+	namespace
+	{
+		uint64_t PackRange(uint32_t begin, uint32_t end)
+		{
+			return uint64_t(end) << 32 | begin;
+		}
+	}
+
+	ThreadPool::ThreadPool(uint32_t threadCount)
+	{
+		if (threadCount == 0) threadCount = std::thread::hardware_concurrency();
+		m_ThreadCount = std::max(threadCount, 1u);
+
+		m_Workers.reserve(m_ThreadCount);
+		for (uint32_t i{}; i < m_ThreadCount; ++i) m_Workers.emplace_back(std::make_unique<Worker>());
+
+		m_Threads.reserve(m_ThreadCount - 1);
+		for (uint32_t i{ 1 }; i < m_ThreadCount; ++i) m_Threads.emplace_back(&ThreadPool::WorkerLoop, this, i);
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard lock{ m_Mutex };
+			m_IsStopping = true;
+		}
+		m_WakeCondition.notify_all();
+
+		for (std::thread& thread : m_Threads) thread.join();
+	}
+
+	void ThreadPool::ParallelFor(uint32_t taskCount, const std::function<void(uint32_t)>& task)
+	{
+		if (taskCount == 0) return;
+
+		{
+			std::lock_guard lock{ m_Mutex };
+			m_pTask = &task;
+			m_PendingTasks = taskCount;
+
+			//neighbouring tasks (tiles) stay on the same worker, stealing only kicks in once a worker runs dry
+			for (uint32_t i{}; i < m_ThreadCount; ++i)
+			{
+				const uint32_t begin{ uint32_t(uint64_t(i) * taskCount / m_ThreadCount) };
+				const uint32_t end{ uint32_t(uint64_t(i + 1) * taskCount / m_ThreadCount) };
+				m_Workers[i]->tasks = PackRange(begin, end);
+			}
+			++m_Generation;
+		}
+		m_WakeCondition.notify_all();
+
+		RunTasks(0);
+
+		std::unique_lock lock{ m_Mutex };
+		m_DoneCondition.wait(lock, [this]() { return m_PendingTasks == 0; });
+	}
+
+	void ThreadPool::WorkerLoop(uint32_t workerIndex)
+	{
+		uint64_t generation{};
+		while (true)
+		{
+			{
+				std::unique_lock lock{ m_Mutex };
+				m_WakeCondition.wait(lock, [&]() { return m_IsStopping || m_Generation != generation; });
+				if (m_IsStopping) return;
+				generation = m_Generation;
+			}
+
+			RunTasks(workerIndex);
+		}
+	}
+
+	void ThreadPool::RunTasks(uint32_t workerIndex)
+	{
+		uint32_t task{};
+		while (PopTask(workerIndex, task))
+		{
+			(*m_pTask)(task);
+
+			if (m_PendingTasks.fetch_sub(1) == 1)
+			{
+				std::lock_guard lock{ m_Mutex };
+				m_DoneCondition.notify_all();
+			}
+		}
+	}
+
+	bool ThreadPool::PopTask(uint32_t workerIndex, uint32_t& task)
+	{
+		if (TakeTask(*m_Workers[workerIndex], false, task)) return true;
+
+		//steal from the far end of another worker's block, away from the tiles it is about to work on
+		for (uint32_t i{ 1 }; i < m_ThreadCount; ++i)
+		{
+			if (TakeTask(*m_Workers[(workerIndex + i) % m_ThreadCount], true, task)) return true;
+		}
+		return false;
+	}
+
+	bool ThreadPool::TakeTask(Worker& worker, bool isStealing, uint32_t& task)
+	{
+		uint64_t range{ worker.tasks.load() };
+		while (true)
+		{
+			const uint32_t begin{ uint32_t(range) }, end{ uint32_t(range >> 32) };
+			if (begin >= end) return false;
+
+			//both ends live in one word, so the owner and a thief can never take the same last task
+			const uint64_t remaining{ isStealing ? PackRange(begin, end - 1) : PackRange(begin + 1, end) };
+			if (worker.tasks.compare_exchange_weak(range, remaining))
+			{
+				task = isStealing ? end - 1 : begin;
+				return true;
+			}
+		}
+	}
+}
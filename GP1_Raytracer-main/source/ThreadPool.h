@@ -0,0 +1,62 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dae
+{
+	//Persistent worker threads that run batches of indexed tasks (render tiles).
+	//Every worker owns a contiguous block of the batch as an atomic [begin, end) range, so starting a batch allocates nothing.
+	//A worker takes tasks from the front of its own range, idle workers steal from the back of the others
+	class ThreadPool final
+	{
+	public:
+		//threadCount includes the calling thread, 0 uses every hardware thread
+		explicit ThreadPool(uint32_t threadCount = 0);
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool(ThreadPool&&) noexcept = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+		ThreadPool& operator=(ThreadPool&&) noexcept = delete;
+
+		/**
+		 * \brief Runs task(i) for every i in [0, taskCount) and returns once all of them finished
+		 * \param task called concurrently from the workers and the calling thread
+		 */
+		void ParallelFor(uint32_t taskCount, const std::function<void(uint32_t)>& task);
+
+		uint32_t GetThreadCount() const { return m_ThreadCount; }
+
+	private:
+		//on a cache line of its own, the owner and the thieves hammer it from different cores
+		struct alignas(64) Worker
+		{
+			std::atomic<uint64_t> tasks{}; //begin in the low 32 bits, end in the high ones
+		};
+
+		void WorkerLoop(uint32_t workerIndex);
+		void RunTasks(uint32_t workerIndex);
+		bool PopTask(uint32_t workerIndex, uint32_t& task);
+		//takes the first or the last task of the worker's range, false once it is empty
+		static bool TakeTask(Worker& worker, bool isStealing, uint32_t& task);
+
+		uint32_t m_ThreadCount{};
+		std::vector<std::unique_ptr<Worker>> m_Workers{}; //index 0 belongs to the thread calling ParallelFor
+		std::vector<std::thread> m_Threads{};
+
+		const std::function<void(uint32_t)>* m_pTask{};
+		std::atomic<uint32_t> m_PendingTasks{};
+
+		std::mutex m_Mutex{};
+		std::condition_variable m_WakeCondition{};
+		std::condition_variable m_DoneCondition{};
+		uint64_t m_Generation{};
+		bool m_IsStopping{ false };
+	};
+}
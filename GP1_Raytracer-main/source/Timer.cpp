@@ -1,30 +1,33 @@
 #include "Timer.h"
 
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
 #include <iostream>
 #include <numeric>
 #include <fstream>
-#include<Windows.h>
 
-#ifdef min
-#undef min
-#endif
-
-#ifdef max
-#undef max
-#endif
-
-#include "SDL.h"
+#include "Console.h"
 using namespace dae;
 
+namespace
+{
+	//steady_clock instead of SDL's counter, so the renderer's core does not need SDL
+	uint64_t GetPerformanceCounter()
+	{
+		return uint64_t(std::chrono::steady_clock::now().time_since_epoch().count());
+	}
+}
+
 Timer::Timer()
 {
-	const uint64_t countsPerSecond = SDL_GetPerformanceFrequency();
-	m_SecondsPerCount = 1.0f / static_cast<float>(countsPerSecond);
+	using Period = std::chrono::steady_clock::period;
+	m_SecondsPerCount = static_cast<float>(Period::num) / static_cast<float>(Period::den);
 }
 
 void Timer::Reset()
 {
-	const uint64_t currentTime = SDL_GetPerformanceCounter();
+	const uint64_t currentTime = GetPerformanceCounter();
 
 	m_BaseTime = currentTime;
 	m_PreviousTime = currentTime;
@@ -36,7 +39,7 @@ void Timer::Reset()
 
 void Timer::Start()
 {
-	const uint64_t startTime = SDL_GetPerformanceCounter();
+	const uint64_t startTime = GetPerformanceCounter();
 
 	if (m_IsStopped)
 	{
@@ -50,13 +53,12 @@ void Timer::Start()
 
 void Timer::StartBenchmark(int numFrames)
 {
-	HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
-	SetConsoleTextAttribute(hConsole, 0x0c);
+	SetConsoleColor(ConsoleColor::Red);
 
 	if (m_BenchmarkActive)
 	{
 		std::cout << "(Benchmark already running)" << std::endl;
-		SetConsoleTextAttribute(hConsole, 0x07);
+		SetConsoleColor(ConsoleColor::Default);
 		return;
 	}
 
@@ -74,7 +76,7 @@ void Timer::StartBenchmark(int numFrames)
 
 	std::cout << "**BENCHMARK STARTED**\n";
 
-	SetConsoleTextAttribute(hConsole, 0x07);
+	SetConsoleColor(ConsoleColor::Default);
 }
 
 void Timer::Update()
@@ -87,7 +89,7 @@ void Timer::Update()
 		return;
 	}
 
-	const uint64_t currentTime = SDL_GetPerformanceCounter();
+	const uint64_t currentTime = GetPerformanceCounter();
 	m_CurrentTime = currentTime;
 
 	m_ElapsedTime = (float)((m_CurrentTime - m_PreviousTime) * m_SecondsPerCount);
@@ -103,6 +105,12 @@ void Timer::Update()
 
 	m_TotalTime = (float)(((m_CurrentTime - m_PausedTime) - m_BaseTime) * m_SecondsPerCount);
 
+	if (m_FixedTimeStep > 0.0f)
+	{
+		m_ElapsedTime = m_FixedTimeStep;
+		m_TotalTime = m_FixedTime += m_FixedTimeStep;
+	}
+
 	//FPS LOGIC
 	m_FPSTimer += m_ElapsedTime;
 	++m_FPSCount;
@@ -123,19 +131,18 @@ void Timer::Update()
 			++m_BenchmarkCurrFrame;
 			if (m_BenchmarkCurrFrame >= m_BenchmarkFrames)
 			{
-				HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
-				SetConsoleTextAttribute(hConsole, 0x0c);
+				SetConsoleColor(ConsoleColor::Red);
 
 				m_BenchmarkActive = false;
 				m_BenchmarkAvg = std::accumulate(m_Benchmarks.begin(), m_Benchmarks.end(), 0.f) / float(m_BenchmarkFrames);
 
 				//print
 				std::cout << "**BENCHMARK FINISHED**\n";
-				SetConsoleTextAttribute(hConsole, 0x0a);
+				SetConsoleColor(ConsoleColor::Green);
 				std::cout << ">> HIGH = " << m_BenchmarkHigh << std::endl;
-				SetConsoleTextAttribute(hConsole, 0x04);
+				SetConsoleColor(ConsoleColor::DarkRed);
 				std::cout << ">> LOW = " << m_BenchmarkLow << std::endl;
-				SetConsoleTextAttribute(hConsole, 0x0e);
+				SetConsoleColor(ConsoleColor::Yellow);
 				std::cout << ">> AVG = " << m_BenchmarkAvg << std::endl;
 
 				//file save
@@ -146,7 +153,7 @@ void Timer::Update()
 				fileStream << "AVG = " << m_BenchmarkAvg << std::endl;
 				fileStream.close();
 
-				SetConsoleTextAttribute(hConsole, 0x07);
+				SetConsoleColor(ConsoleColor::Default);
 			}
 		}
 	}
@@ -156,7 +163,7 @@ void Timer::Stop()
 {
 	if (!m_IsStopped)
 	{
-		const uint64_t currentTime = SDL_GetPerformanceCounter();
+		const uint64_t currentTime = GetPerformanceCounter();
 
 		m_StopTime = currentTime;
 		m_IsStopped = true;
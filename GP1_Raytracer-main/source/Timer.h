@@ -24,6 +24,10 @@ namespace dae
 		void Update();
 		void Stop();
 
+		//Every Update advances the clock by exactly this many seconds instead of the real time, 0 turns it off.
+		//Makes offline renders of animated scenes independent of how long a frame took
+		void SetFixedTimeStep(float seconds) { m_FixedTimeStep = seconds; };
+
 		uint32_t GetFPS() const { return m_FPS; };
 		float GetdFPS() const { return m_dFPS; };
 		float GetElapsed() const { return m_ElapsedTime; };
@@ -46,6 +50,8 @@ namespace dae
 		float m_SecondsPerCount = 0.0f;
 		float m_ElapsedUpperBound = 0.03f;
 		float m_FPSTimer = 0.0f;
+		float m_FixedTimeStep = 0.0f;
+		float m_FixedTime = 0.0f;
 
 		bool m_IsStopped = true;
 		bool m_ForceElapsedUpperBound = false;
@@ -0,0 +1,231 @@
+#include "Tonemapper.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define TONEMAPPER_SSE
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define TONEMAPPER_NEON
+#include <arm_neon.h>
+#endif
+
+namespace dae
+{
+	namespace
+	{
+		//Narkowicz's ACES fit, (x (a x + b)) / (x (c x + d) + e)
+		constexpr float AcesA{ 2.51f }, AcesB{ .03f }, AcesC{ 2.43f }, AcesD{ .59f }, AcesE{ .14f };
+
+		//The handful of four lane operations the resolve needs, so the loop below is written once for SSE and NEON
+#if defined(TONEMAPPER_SSE)
+		using Float4 = __m128;
+		using UInt4 = __m128i;
+
+		Float4 Set(float value) { return _mm_set1_ps(value); }
+		Float4 Add(Float4 a, Float4 b) { return _mm_add_ps(a, b); }
+		Float4 Mul(Float4 a, Float4 b) { return _mm_mul_ps(a, b); }
+		Float4 Div(Float4 a, Float4 b) { return _mm_div_ps(a, b); }
+		Float4 Min(Float4 a, Float4 b) { return _mm_min_ps(a, b); }
+		Float4 Max(Float4 a, Float4 b) { return _mm_max_ps(a, b); }
+		//values are in [0, LutSize), the signed conversion is enough
+		UInt4 Truncate(Float4 value) { return _mm_cvttps_epi32(value); }
+		UInt4 SetInts(uint32_t a, uint32_t b, uint32_t c, uint32_t d) { return _mm_setr_epi32(int(a), int(b), int(c), int(d)); }
+		void Store(uint32_t* pValues, UInt4 values) { _mm_storeu_si128(reinterpret_cast<__m128i*>(pValues), values); }
+
+		Float4 LoadSampleCounts(const uint32_t* pSampleCounts)
+		{
+			return _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pSampleCounts)));
+		}
+
+		//r0 g0 b0 r1 | g1 b1 r2 g2 | b2 r3 g3 b3 -> one register per channel
+		void LoadColors(const ColorRGB* pColors, Float4& red, Float4& green, Float4& blue)
+		{
+			const float* pValues{ &pColors->r };
+			const __m128 a{ _mm_loadu_ps(pValues) }, b{ _mm_loadu_ps(pValues + 4) }, c{ _mm_loadu_ps(pValues + 8) };
+			red = _mm_shuffle_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 0, 0)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 2, 0));
+			green = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+			blue = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+		}
+
+		void StorePixels(uint32_t* pPixels, UInt4 red, UInt4 green, UInt4 blue)
+		{
+			const __m128i pixels{ _mm_or_si128(_mm_or_si128(_mm_set1_epi32(int(0xFF000000)), _mm_slli_epi32(red, 16)), _mm_or_si128(_mm_slli_epi32(green, 8), blue)) };
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pPixels), pixels);
+		}
+#elif defined(TONEMAPPER_NEON)
+		using Float4 = float32x4_t;
+		using UInt4 = uint32x4_t;
+
+		Float4 Set(float value) { return vdupq_n_f32(value); }
+		Float4 Add(Float4 a, Float4 b) { return vaddq_f32(a, b); }
+		Float4 Mul(Float4 a, Float4 b) { return vmulq_f32(a, b); }
+		Float4 Div(Float4 a, Float4 b) { return vdivq_f32(a, b); }
+		Float4 Min(Float4 a, Float4 b) { return vminq_f32(a, b); }
+		Float4 Max(Float4 a, Float4 b) { return vmaxq_f32(a, b); }
+		UInt4 Truncate(Float4 value) { return vcvtq_u32_f32(value); }
+		UInt4 SetInts(uint32_t a, uint32_t b, uint32_t c, uint32_t d)
+		{
+			const uint32_t values[4]{ a, b, c, d };
+			return vld1q_u32(values);
+		}
+		void Store(uint32_t* pValues, UInt4 values) { vst1q_u32(pValues, values); }
+
+		Float4 LoadSampleCounts(const uint32_t* pSampleCounts)
+		{
+			return vcvtq_f32_u32(vld1q_u32(pSampleCounts));
+		}
+
+		void LoadColors(const ColorRGB* pColors, Float4& red, Float4& green, Float4& blue)
+		{
+			const float32x4x3_t channels{ vld3q_f32(&pColors->r) };
+			red = channels.val[0];
+			green = channels.val[1];
+			blue = channels.val[2];
+		}
+
+		void StorePixels(uint32_t* pPixels, UInt4 red, UInt4 green, UInt4 blue)
+		{
+			vst1q_u32(pPixels, vorrq_u32(vorrq_u32(vdupq_n_u32(0xFF000000), vshlq_n_u32(red, 16)), vorrq_u32(vshlq_n_u32(green, 8), blue)));
+		}
+#endif
+	}
+
+	Tonemapper::Tonemapper()
+	{
+		static_assert(sizeof(ColorRGB) == 3 * sizeof(float), "the resolve loads ColorRGBs as packed floats");
+
+		for (uint32_t i{}; i < LutSize; ++i)
+		{
+			const float linear{ float(i) / (LutSize - 1) };
+			const float encoded{ linear <= .0031308f ? 12.92f * linear : 1.055f * powf(linear, 1.f / 2.4f) - .055f };
+			m_SRGBTable[i] = uint8_t(std::min(encoded * 255.f + .5f, 255.f));
+		}
+	}
+
+	void Tonemapper::Resolve(const ColorRGB* pSums, const uint32_t* pSampleCounts, uint32_t* pPixels, uint32_t count) const
+	{
+		uint32_t i{};
+#if defined(TONEMAPPER_SSE) || defined(TONEMAPPER_NEON)
+		const Float4 zero{ Set(0.f) }, one{ Set(1.f) }, exposureScale{ Set(m_ExposureScale) };
+
+		//same operations in the same order as ResolvePixel, so a pixel comes out the same in either
+		const auto quantize{ [&](Float4 value)
+			{
+				value = Min(Max(value, zero), one);
+				if (!m_IsSRGB) return Truncate(Mul(value, Set(255.f)));
+
+				uint32_t indices[4]{};
+				Store(indices, Truncate(Add(Mul(value, Set(LutSize - 1.f)), Set(.5f))));
+				return SetInts(m_SRGBTable[indices[0]], m_SRGBTable[indices[1]], m_SRGBTable[indices[2]], m_SRGBTable[indices[3]]);
+			} };
+
+		for (; i + 4 <= count; i += 4)
+		{
+			Float4 red{}, green{}, blue{};
+			LoadColors(pSums + i, red, green, blue);
+
+			const Float4 scale{ Mul(Div(one, Max(LoadSampleCounts(pSampleCounts + i), one)), exposureScale) };
+			red = Mul(red, scale);
+			green = Mul(green, scale);
+			blue = Mul(blue, scale);
+
+			switch (m_Curve)
+			{
+			case Curve::Clamp:
+			{
+				//dividing by 1 leaves the colors that fit alone, like ColorRGB::MaxToOne
+				const Float4 divisor{ Max(Max(red, Max(green, blue)), one) };
+				red = Div(red, divisor);
+				green = Div(green, divisor);
+				blue = Div(blue, divisor);
+				break;
+			}
+			case Curve::Reinhard:
+				red = Div(red, Add(red, one));
+				green = Div(green, Add(green, one));
+				blue = Div(blue, Add(blue, one));
+				break;
+			case Curve::ACES:
+			{
+				const auto aces{ [&](Float4 x)
+					{
+						return Div(Mul(x, Add(Mul(x, Set(AcesA)), Set(AcesB))), Add(Mul(x, Add(Mul(x, Set(AcesC)), Set(AcesD))), Set(AcesE)));
+					} };
+				red = aces(red);
+				green = aces(green);
+				blue = aces(blue);
+				break;
+			}
+			}
+
+			StorePixels(pPixels + i, quantize(red), quantize(green), quantize(blue));
+		}
+#endif
+		for (; i < count; ++i)
+		{
+			pPixels[i] = ResolvePixel(pSums[i], pSampleCounts[i]);
+		}
+	}
+
+	uint32_t Tonemapper::ResolvePixel(const ColorRGB& sum, uint32_t sampleCount) const
+	{
+		const float scale{ (1.f / std::max(float(sampleCount), 1.f)) * m_ExposureScale };
+		ColorRGB color{ sum * scale };
+		ApplyCurve(color);
+		return 0xFF000000 | (Quantize(color.r) << 16) | (Quantize(color.g) << 8) | Quantize(color.b);
+	}
+
+	void Tonemapper::ApplyCurve(ColorRGB& color) const
+	{
+		switch (m_Curve)
+		{
+		case Curve::Clamp:
+			color.MaxToOne();
+			break;
+		case Curve::Reinhard:
+			color = { color.r / (color.r + 1.f), color.g / (color.g + 1.f), color.b / (color.b + 1.f) };
+			break;
+		case Curve::ACES:
+			for (float* pValue : { &color.r, &color.g, &color.b })
+			{
+				const float x{ *pValue };
+				*pValue = (x * (x * AcesA + AcesB)) / (x * (x * AcesC + AcesD) + AcesE);
+			}
+			break;
+		}
+	}
+
+	uint32_t Tonemapper::Quantize(float value) const
+	{
+		value = std::min(std::max(0.f, value), 1.f);
+		if (!m_IsSRGB) return uint32_t(value * 255.f);
+		return m_SRGBTable[uint32_t(value * (LutSize - 1.f) + .5f)];
+	}
+
+	void Tonemapper::SetExposure(float stops)
+	{
+		m_Exposure = stops;
+		m_ExposureScale = exp2f(stops);
+	}
+
+	void Tonemapper::CycleCurve()
+	{
+		m_Curve = static_cast<Curve>((int(m_Curve) + 1) % 3);
+	}
+
+	const char* Tonemapper::GetCurveName(Curve curve)
+	{
+		switch (curve)
+		{
+		case Curve::Clamp:
+			return "Clamp";
+		case Curve::Reinhard:
+			return "Reinhard";
+		case Curve::ACES:
+			return "ACES";
+		}
+		return "";
+	}
+}
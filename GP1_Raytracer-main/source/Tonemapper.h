@@ -0,0 +1,65 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+#include "ColorRGB.h"
+
+namespace dae
+{
+	//Turns accumulated linear radiance into 8 bit pixels once per frame: exposure, a tonemapping curve, the output
+	//transfer function and packing to 0xAARRGGBB, four pixels at a time with SSE or NEON
+	class Tonemapper final
+	{
+	public:
+		enum class Curve
+		{
+			Clamp,		//scales colors brighter than 1 back down, keeping their hue. What the shading always did
+			Reinhard,	//c / (1 + c) per channel
+			ACES		//Narkowicz's fit of the ACES filmic curve
+		};
+
+		Tonemapper();
+		~Tonemapper() = default;
+
+		Tonemapper(const Tonemapper&) = delete;
+		Tonemapper(Tonemapper&&) noexcept = delete;
+		Tonemapper& operator=(const Tonemapper&) = delete;
+		Tonemapper& operator=(Tonemapper&&) noexcept = delete;
+
+		/**
+		 * \brief Resolves a run of pixels, e.g. one row of the framebuffer
+		 * \param pSums running sample sums, a pixel shows sum / sampleCount
+		 * \param pSampleCounts samples per pixel, 0 is treated as 1
+		 * \param pPixels receives the 0xAARRGGBB pixels
+		 */
+		void Resolve(const ColorRGB* pSums, const uint32_t* pSampleCounts, uint32_t* pPixels, uint32_t count) const;
+
+		//Exposure in stops, the radiance is scaled by 2^stops before the curve
+		void SetExposure(float stops);
+		float GetExposure() const { return m_Exposure; }
+		float GetExposureScale() const { return m_ExposureScale; }
+		void SetCurve(Curve curve) { m_Curve = curve; }
+		Curve GetCurve() const { return m_Curve; }
+		void CycleCurve();
+		//sRGB gamma through a lookup table, off writes the curve's output linearly
+		void SetSRGB(bool isSRGB) { m_IsSRGB = isSRGB; }
+		bool IsSRGB() const { return m_IsSRGB; }
+
+		static const char* GetCurveName(Curve curve);
+
+	private:
+		//the scalar version of Resolve for a single pixel, also finishes the rows that are not a multiple of four
+		uint32_t ResolvePixel(const ColorRGB& sum, uint32_t sampleCount) const;
+		void ApplyCurve(ColorRGB& color) const;
+		uint32_t Quantize(float value) const;
+
+		//[0, 1] in LutSize steps, neighbouring entries stay less than an 8 bit level apart even on the steep linear toe
+		static constexpr uint32_t LutSize{ 4096 };
+		std::array<uint8_t, LutSize> m_SRGBTable{};
+
+		float m_Exposure{};
+		float m_ExposureScale{ 1.f };
+		Curve m_Curve{ Curve::Clamp };
+		bool m_IsSRGB{ false };
+	};
+}
@@ -0,0 +1,276 @@
+#include "TriangleKernels.h"
+
+#include "Utils.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define TRIANGLE_KERNELS_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define AVX2_TARGET
+#else
+#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace dae
+{
+	namespace TriangleKernels
+	{
+		namespace
+		{
+			bool Intersect_Scalar(const TriangleSoA& triangles, uint32_t first, uint32_t count, TriangleCullMode cullMode, const Ray& ray, float& closestT, uint32_t& closestIndex)
+			{
+				bool hasHit{ false };
+				const uint32_t end{ first + count };
+				for (uint32_t i{ first }; i < end; ++i)
+				{
+					float t{};
+					if (!GeometryUtils::HitTest_MeshTriangle(triangles.GetV0(i), triangles.GetEdge1(i), triangles.GetEdge2(i), cullMode, ray, t)) continue;
+
+					if (t < closestT)
+					{
+						closestT = t;
+						closestIndex = i;
+						hasHit = true;
+					}
+				}
+				return hasHit;
+			}
+
+#if defined(TRIANGLE_KERNELS_X86)
+			//The vector kernels do exactly the operations of HitTest_MeshTriangle in the same order (no FMA),
+			//so every lane produces bit-identical results to the scalar path.
+
+			bool Intersect_SSE(const TriangleSoA& triangles, uint32_t first, uint32_t count, TriangleCullMode cullMode, const Ray& ray, float& closestT, uint32_t& closestIndex)
+			{
+				const __m128 dx{ _mm_set1_ps(ray.direction.x) }, dy{ _mm_set1_ps(ray.direction.y) }, dz{ _mm_set1_ps(ray.direction.z) };
+				const __m128 ox{ _mm_set1_ps(ray.origin.x) }, oy{ _mm_set1_ps(ray.origin.y) }, oz{ _mm_set1_ps(ray.origin.z) };
+				const __m128 zero{ _mm_setzero_ps() }, one{ _mm_set1_ps(1.f) };
+				const __m128 epsilon{ _mm_set1_ps(FLT_EPSILON) }, negativeEpsilon{ _mm_set1_ps(-FLT_EPSILON) };
+				const __m128 rayMin{ _mm_set1_ps(ray.min) }, rayMax{ _mm_set1_ps(ray.max) };
+				const __m128i laneIndices{ _mm_setr_epi32(0, 1, 2, 3) };
+
+				bool hasHit{ false };
+				for (uint32_t batch{}; batch < count; batch += 4)
+				{
+					const uint32_t i{ first + batch };
+					const __m128 e1x{ _mm_loadu_ps(&triangles.edge1x[i]) }, e1y{ _mm_loadu_ps(&triangles.edge1y[i]) }, e1z{ _mm_loadu_ps(&triangles.edge1z[i]) };
+					const __m128 e2x{ _mm_loadu_ps(&triangles.edge2x[i]) }, e2y{ _mm_loadu_ps(&triangles.edge2y[i]) }, e2z{ _mm_loadu_ps(&triangles.edge2z[i]) };
+
+					//h = Cross(direction, edge2), a = Dot(edge1, h)
+					const __m128 hx{ _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y)) };
+					const __m128 hy{ _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z)) };
+					const __m128 hz{ _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x)) };
+					const __m128 a{ _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, hx), _mm_mul_ps(e1y, hy)), _mm_mul_ps(e1z, hz)) };
+
+					__m128 reject{ _mm_castsi128_ps(_mm_cmpgt_epi32(laneIndices, _mm_set1_epi32(static_cast<int>(count - batch - 1)))) };
+					if (cullMode == TriangleCullMode::BackFaceCulling) reject = _mm_or_ps(reject, _mm_cmplt_ps(a, negativeEpsilon));
+					if (cullMode == TriangleCullMode::FrontFaceCulling) reject = _mm_or_ps(reject, _mm_cmpgt_ps(a, epsilon));
+
+					const __m128 f{ _mm_div_ps(one, a) };
+					const __m128 sx{ _mm_sub_ps(ox, _mm_loadu_ps(&triangles.v0x[i])) };
+					const __m128 sy{ _mm_sub_ps(oy, _mm_loadu_ps(&triangles.v0y[i])) };
+					const __m128 sz{ _mm_sub_ps(oz, _mm_loadu_ps(&triangles.v0z[i])) };
+					const __m128 u{ _mm_mul_ps(f, _mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, hx), _mm_mul_ps(sy, hy)), _mm_mul_ps(sz, hz))) };
+					reject = _mm_or_ps(reject, _mm_or_ps(_mm_cmplt_ps(u, zero), _mm_cmpgt_ps(u, one)));
+
+					//q = Cross(s, edge1)
+					const __m128 qx{ _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y)) };
+					const __m128 qy{ _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z)) };
+					const __m128 qz{ _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x)) };
+					const __m128 v{ _mm_mul_ps(f, _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz))) };
+					reject = _mm_or_ps(reject, _mm_or_ps(_mm_cmplt_ps(v, zero), _mm_cmpgt_ps(_mm_add_ps(u, v), one)));
+
+					const __m128 t{ _mm_mul_ps(f, _mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz))) };
+					reject = _mm_or_ps(reject, _mm_or_ps(_mm_cmpgt_ps(t, rayMax), _mm_cmplt_ps(t, rayMin)));
+
+					const int hitMask{ _mm_movemask_ps(_mm_andnot_ps(reject, _mm_cmplt_ps(t, _mm_set1_ps(closestT)))) };
+					if (hitMask == 0) continue;
+
+					//resolve in lane order, same tie-breaking as the scalar loop
+					alignas(16) float distances[4];
+					_mm_store_ps(distances, t);
+					for (int lane{}; lane < 4; ++lane)
+					{
+						if ((hitMask & (1 << lane)) && distances[lane] < closestT)
+						{
+							closestT = distances[lane];
+							closestIndex = i + lane;
+							hasHit = true;
+						}
+					}
+				}
+				return hasHit;
+			}
+
+			AVX2_TARGET bool Intersect_AVX2(const TriangleSoA& triangles, uint32_t first, uint32_t count, TriangleCullMode cullMode, const Ray& ray, float& closestT, uint32_t& closestIndex)
+			{
+				const __m256 dx{ _mm256_set1_ps(ray.direction.x) }, dy{ _mm256_set1_ps(ray.direction.y) }, dz{ _mm256_set1_ps(ray.direction.z) };
+				const __m256 ox{ _mm256_set1_ps(ray.origin.x) }, oy{ _mm256_set1_ps(ray.origin.y) }, oz{ _mm256_set1_ps(ray.origin.z) };
+				const __m256 zero{ _mm256_setzero_ps() }, one{ _mm256_set1_ps(1.f) };
+				const __m256 epsilon{ _mm256_set1_ps(FLT_EPSILON) }, negativeEpsilon{ _mm256_set1_ps(-FLT_EPSILON) };
+				const __m256 rayMin{ _mm256_set1_ps(ray.min) }, rayMax{ _mm256_set1_ps(ray.max) };
+				const __m256i laneIndices{ _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7) };
+
+				bool hasHit{ false };
+				for (uint32_t batch{}; batch < count; batch += 8)
+				{
+					const uint32_t i{ first + batch };
+					const __m256 e1x{ _mm256_loadu_ps(&triangles.edge1x[i]) }, e1y{ _mm256_loadu_ps(&triangles.edge1y[i]) }, e1z{ _mm256_loadu_ps(&triangles.edge1z[i]) };
+					const __m256 e2x{ _mm256_loadu_ps(&triangles.edge2x[i]) }, e2y{ _mm256_loadu_ps(&triangles.edge2y[i]) }, e2z{ _mm256_loadu_ps(&triangles.edge2z[i]) };
+
+					//h = Cross(direction, edge2), a = Dot(edge1, h)
+					const __m256 hx{ _mm256_sub_ps(_mm256_mul_ps(dy, e2z), _mm256_mul_ps(dz, e2y)) };
+					const __m256 hy{ _mm256_sub_ps(_mm256_mul_ps(dz, e2x), _mm256_mul_ps(dx, e2z)) };
+					const __m256 hz{ _mm256_sub_ps(_mm256_mul_ps(dx, e2y), _mm256_mul_ps(dy, e2x)) };
+					const __m256 a{ _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e1x, hx), _mm256_mul_ps(e1y, hy)), _mm256_mul_ps(e1z, hz)) };
+
+					__m256 reject{ _mm256_castsi256_ps(_mm256_cmpgt_epi32(laneIndices, _mm256_set1_epi32(static_cast<int>(count - batch - 1)))) };
+					if (cullMode == TriangleCullMode::BackFaceCulling) reject = _mm256_or_ps(reject, _mm256_cmp_ps(a, negativeEpsilon, _CMP_LT_OQ));
+					if (cullMode == TriangleCullMode::FrontFaceCulling) reject = _mm256_or_ps(reject, _mm256_cmp_ps(a, epsilon, _CMP_GT_OQ));
+
+					const __m256 f{ _mm256_div_ps(one, a) };
+					const __m256 sx{ _mm256_sub_ps(ox, _mm256_loadu_ps(&triangles.v0x[i])) };
+					const __m256 sy{ _mm256_sub_ps(oy, _mm256_loadu_ps(&triangles.v0y[i])) };
+					const __m256 sz{ _mm256_sub_ps(oz, _mm256_loadu_ps(&triangles.v0z[i])) };
+					const __m256 u{ _mm256_mul_ps(f, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(sx, hx), _mm256_mul_ps(sy, hy)), _mm256_mul_ps(sz, hz))) };
+					reject = _mm256_or_ps(reject, _mm256_or_ps(_mm256_cmp_ps(u, zero, _CMP_LT_OQ), _mm256_cmp_ps(u, one, _CMP_GT_OQ)));
+
+					//q = Cross(s, edge1)
+					const __m256 qx{ _mm256_sub_ps(_mm256_mul_ps(sy, e1z), _mm256_mul_ps(sz, e1y)) };
+					const __m256 qy{ _mm256_sub_ps(_mm256_mul_ps(sz, e1x), _mm256_mul_ps(sx, e1z)) };
+					const __m256 qz{ _mm256_sub_ps(_mm256_mul_ps(sx, e1y), _mm256_mul_ps(sy, e1x)) };
+					const __m256 v{ _mm256_mul_ps(f, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, qx), _mm256_mul_ps(dy, qy)), _mm256_mul_ps(dz, qz))) };
+					reject = _mm256_or_ps(reject, _mm256_or_ps(_mm256_cmp_ps(v, zero, _CMP_LT_OQ), _mm256_cmp_ps(_mm256_add_ps(u, v), one, _CMP_GT_OQ)));
+
+					const __m256 t{ _mm256_mul_ps(f, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e2x, qx), _mm256_mul_ps(e2y, qy)), _mm256_mul_ps(e2z, qz))) };
+					reject = _mm256_or_ps(reject, _mm256_or_ps(_mm256_cmp_ps(t, rayMax, _CMP_GT_OQ), _mm256_cmp_ps(t, rayMin, _CMP_LT_OQ)));
+
+					const int hitMask{ _mm256_movemask_ps(_mm256_andnot_ps(reject, _mm256_cmp_ps(t, _mm256_set1_ps(closestT), _CMP_LT_OQ))) };
+					if (hitMask == 0) continue;
+
+					//resolve in lane order, same tie-breaking as the scalar loop
+					alignas(32) float distances[8];
+					_mm256_store_ps(distances, t);
+					for (int lane{}; lane < 8; ++lane)
+					{
+						if ((hitMask & (1 << lane)) && distances[lane] < closestT)
+						{
+							closestT = distances[lane];
+							closestIndex = i + lane;
+							hasHit = true;
+						}
+					}
+				}
+				return hasHit;
+			}
+
+			bool CpuSupportsAVX2()
+			{
+#if defined(_MSC_VER)
+				int info[4]{};
+				__cpuid(info, 0);
+				if (info[0] < 7) return false;
+
+				//the OS has to save the upper halves of the ymm registers as well
+				__cpuid(info, 1);
+				const bool osSavesYmm{ (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6 };
+				if (!osSavesYmm || (info[2] & (1 << 28)) == 0) return false;
+
+				__cpuidex(info, 7, 0);
+				return (info[1] & (1 << 5)) != 0;
+#else
+				return __builtin_cpu_supports("avx2");
+#endif
+			}
+#endif
+
+			KernelType DetectBestKernel()
+			{
+#if defined(TRIANGLE_KERNELS_X86)
+				return CpuSupportsAVX2() ? KernelType::AVX2 : KernelType::SSE;
+#else
+				return KernelType::Scalar;
+#endif
+			}
+
+			IntersectFunction GetFunction(KernelType kernel)
+			{
+				switch (kernel)
+				{
+#if defined(TRIANGLE_KERNELS_X86)
+				case KernelType::SSE:
+					return Intersect_SSE;
+				case KernelType::AVX2:
+					return Intersect_AVX2;
+#endif
+				default:
+					return Intersect_Scalar;
+				}
+			}
+
+			KernelType g_ActiveKernel{ DetectBestKernel() };
+			IntersectFunction g_IntersectFunction{ GetFunction(g_ActiveKernel) };
+		}
+
+		IntersectFunction GetIntersectFunction()
+		{
+			return g_IntersectFunction;
+		}
+
+		KernelType GetActiveKernel()
+		{
+			return g_ActiveKernel;
+		}
+
+		bool IsKernelSupported(KernelType kernel)
+		{
+			switch (kernel)
+			{
+			case KernelType::Scalar:
+				return true;
+#if defined(TRIANGLE_KERNELS_X86)
+			case KernelType::SSE:
+				return true;
+			case KernelType::AVX2:
+				return CpuSupportsAVX2();
+#endif
+			default:
+				return false;
+			}
+		}
+
+		void SetActiveKernel(KernelType kernel)
+		{
+			if (!IsKernelSupported(kernel)) return;
+
+			g_ActiveKernel = kernel;
+			g_IntersectFunction = GetFunction(kernel);
+		}
+
+		void CycleActiveKernel()
+		{
+			KernelType next{ g_ActiveKernel };
+			do
+			{
+				next = static_cast<KernelType>((static_cast<int>(next) + 1) % 3);
+			} while (!IsKernelSupported(next));
+
+			SetActiveKernel(next);
+		}
+
+		const char* GetKernelName(KernelType kernel)
+		{
+			switch (kernel)
+			{
+			case KernelType::SSE:
+				return "SSE (4-wide)";
+			case KernelType::AVX2:
+				return "AVX2 (8-wide)";
+			default:
+				return "Scalar";
+			}
+		}
+	}
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+
+#include "DataTypes.h"
+
+namespace dae
+{
+	namespace TriangleKernels
+	{
+		enum class KernelType
+		{
+			Scalar,
+			SSE,
+			AVX2
+		};
+
+		/**
+		 * \brief Intersects one ray with a contiguous range of packed triangles (Moller-Trumbore)
+		 * \param triangles packed triangle data, the range is [first, first + count)
+		 * \param closestT only hits closer than this are accepted, lowered to the closest hit found
+		 * \param closestIndex set to the triangle that produced closestT
+		 * \return true when a closer hit was found
+		 */
+		using IntersectFunction = bool(*)(const TriangleSoA& triangles, uint32_t first, uint32_t count, TriangleCullMode cullMode, const Ray& ray, float& closestT, uint32_t& closestIndex);
+
+		//Kernel picked at startup from the CPU features, falls back to scalar
+		IntersectFunction GetIntersectFunction();
+
+		KernelType GetActiveKernel();
+		bool IsKernelSupported(KernelType kernel);
+		void SetActiveKernel(KernelType kernel);
+		//Switches to the next kernel the CPU supports, wrapping around to scalar
+		void CycleActiveKernel();
+
+		const char* GetKernelName(KernelType kernel);
+	}
+}
@@ -3,6 +3,8 @@
 #include <fstream>
 #include "Math.h"
 #include "DataTypes.h"
+#include "FastMath.h"
+#include "TriangleKernels.h"
 
 namespace dae
 {
@@ -157,64 +159,229 @@ namespace dae
 			return HitTest_Triangle(triangle, ray, temp, true);
 		}
 #pragma endregion
-#pragma region TriangeMesh HitTest
-		inline bool HitTest_TriangleMesh(const TriangleMesh& mesh, const Ray& ray, HitRecord& hitRecord, bool ignoreHitRecord = false)
+#pragma region BVH SlabTest
+		//Returns the distance to where the ray enters the node, FLT_MAX when it misses or enters beyond maxDistance
+		inline float SlabTest_BVHNode(const BVHNode& node, const Ray& ray, const Vector3& inverseDirection, float maxDistance)
 		{
-			////todo W5
-			if (!Slabtest_TrianglMesh(mesh, ray)) return false;
+			const float tx1 = (node.minAABB.x - ray.origin.x) * inverseDirection.x;
+			const float tx2 = (node.maxAABB.x - ray.origin.x) * inverseDirection.x;
 
-			bool hasHitSomething{ false };
-			HitRecord temp{};
-			float distance = FLT_MAX;
+			float tmin = std::min(tx1, tx2);
+			float tmax = std::max(tx1, tx2);
+
+			const float ty1 = (node.minAABB.y - ray.origin.y) * inverseDirection.y;
+			const float ty2 = (node.maxAABB.y - ray.origin.y) * inverseDirection.y;
+
+			tmin = std::max(tmin, std::min(ty1, ty2));
+			tmax = std::min(tmax, std::max(ty1, ty2));
+
+			const float tz1 = (node.minAABB.z - ray.origin.z) * inverseDirection.z;
+			const float tz2 = (node.maxAABB.z - ray.origin.z) * inverseDirection.z;
+
+			tmin = std::max(tmin, std::min(tz1, tz2));
+			tmax = std::min(tmax, std::max(tz1, tz2));
+
+			if (tmax >= tmin && tmax > 0 && tmin < maxDistance) return tmin;
+			return FLT_MAX;
+		}
+
+		//True when the segment from start to end touches the box
+		inline bool SlabTest_Segment(const Vector3& minAABB, const Vector3& maxAABB, const Vector3& start, const Vector3& end)
+		{
+			const Vector3 direction{ end - start };
+
+			const float tx1 = (minAABB.x - start.x) / direction.x;
+			const float tx2 = (maxAABB.x - start.x) / direction.x;
+
+			float tmin = std::min(tx1, tx2);
+			float tmax = std::max(tx1, tx2);
+
+			const float ty1 = (minAABB.y - start.y) / direction.y;
+			const float ty2 = (maxAABB.y - start.y) / direction.y;
+
+			tmin = std::max(tmin, std::min(ty1, ty2));
+			tmax = std::min(tmax, std::max(ty1, ty2));
+
+			const float tz1 = (minAABB.z - start.z) / direction.z;
+			const float tz2 = (maxAABB.z - start.z) / direction.z;
+
+			tmin = std::max(tmin, std::min(tz1, tz2));
+			tmax = std::min(tmax, std::max(tz1, tz2));
+
+			return tmax >= tmin && tmax >= 0.f && tmin <= 1.f;
+		}
+
+		/**
+		 * \brief Walks a BVH front to back and hands every leaf the ray reaches to the callback
+		 * \param maxDistance nodes entered beyond this distance are skipped, the callback lowers it when it finds a closer hit
+		 * \param leafCallback bool(const BVHNode& leaf), returning true stops the traversal (any-hit queries)
+		 */
+		//BVH nodes TraverseBVH entered on this thread, read before and after a batch of rays to see how much work they took
+		inline thread_local uint64_t g_VisitedNodeCount{};
 
-			for (int i{}; i < mesh.indices.size(); i += 3)
+		template<typename LeafCallback>
+		inline void TraverseBVH(const std::vector<BVHNode>& nodes, const Ray& ray, const Vector3& inverseDirection, float& maxDistance, LeafCallback&& leafCallback)
+		{
+			if (nodes.empty() || SlabTest_BVHNode(nodes[0], ray, inverseDirection, maxDistance) == FLT_MAX) return;
+
+			uint32_t stack[BVH::MaxDepth]{};
+			uint32_t stackSize{};
+			uint32_t nodeIndex{};
+
+			while (true)
 			{
-				const Vector3& v0{ mesh.transformedPositions[mesh.indices[i]]     };
-				const Vector3& v1{ mesh.transformedPositions[mesh.indices[i + 1]] };
-				const Vector3& v2{ mesh.transformedPositions[mesh.indices[i + 2]] };
+				++g_VisitedNodeCount;
+				const BVHNode& node{ nodes[nodeIndex] };
+				if (node.IsLeaf())
+				{
+					if (leafCallback(node)) return;
 
-				const Vector3 edge1{ v1 - v0 };
-				const Vector3 edge2{ v2 - v0 };
+					if (stackSize == 0) return;
+					nodeIndex = stack[--stackSize];
+					continue;
+				}
 
-				const Vector3 h{ Vector3::Cross(ray.direction, edge2) };
-				const float a{ Vector3::Dot(edge1, h) };
+				//visit the nearest child first so the far one can be culled by the closest hit so far
+				uint32_t nearChild{ node.leftFirst };
+				uint32_t farChild{ node.leftFirst + 1 };
+				float nearDistance{ SlabTest_BVHNode(nodes[nearChild], ray, inverseDirection, maxDistance) };
+				float farDistance{ SlabTest_BVHNode(nodes[farChild], ray, inverseDirection, maxDistance) };
+				if (nearDistance > farDistance)
+				{
+					std::swap(nearDistance, farDistance);
+					std::swap(nearChild, farChild);
+				}
 
-				if (a < -FLT_EPSILON && mesh.cullMode == TriangleCullMode::BackFaceCulling) continue;
-				if (a > FLT_EPSILON && mesh.cullMode == TriangleCullMode::FrontFaceCulling) continue;
+				if (nearDistance == FLT_MAX)
+				{
+					if (stackSize == 0) return;
+					nodeIndex = stack[--stackSize];
+					continue;
+				}
 
-				const float f{ 1.0f / a };
-				const Vector3 s{ ray.origin - v0 };
-				const float u{ f * Vector3::Dot(s, h) };
-				if (u < 0.0 || u > 1.0) continue;
+				nodeIndex = nearChild;
+				if (farDistance != FLT_MAX) stack[stackSize++] = farChild;
+			}
+		}
+#pragma endregion
+#pragma region TriangeMesh HitTest
+		//Moller-Trumbore for a single triangle of a mesh, returns the distance along the ray in t
+		inline bool HitTest_MeshTriangle(const Vector3& v0, const Vector3& edge1, const Vector3& edge2, TriangleCullMode cullMode, const Ray& ray, float& t)
+		{
+			const Vector3 h{ Vector3::Cross(ray.direction, edge2) };
+			const float a{ Vector3::Dot(edge1, h) };
+
+			if (a < -FLT_EPSILON && cullMode == TriangleCullMode::BackFaceCulling) return false;
+			if (a > FLT_EPSILON && cullMode == TriangleCullMode::FrontFaceCulling) return false;
+
+			const float f{ 1.0f / a };
+			const Vector3 s{ ray.origin - v0 };
+			const float u{ f * Vector3::Dot(s, h) };
+			if (u < 0.0 || u > 1.0) return false;
+
+			const Vector3 q{ Vector3::Cross(s, edge1) };
+			const float v{ f * Vector3::Dot(ray.direction, q) };
+			if (v < 0.0 || u + v > 1.0) return false;
 
-				const Vector3 q{ Vector3::Cross(s, edge1) };
-				const float v{ f * Vector3::Dot(ray.direction, q) };
-				if (v < 0.0 || u + v > 1.0) continue;
+			t = f * Vector3::Dot(edge2, q);
+			return !(t > ray.max || t < ray.min);
+		}
+
+		//A mirroring world transform turns the winding around, so the culled side swaps in object space
+		inline TriangleCullMode GetObjectSpaceCullMode(const TriangleMesh& mesh)
+		{
+			if (mesh.flipsWinding && mesh.cullMode == TriangleCullMode::BackFaceCulling) return TriangleCullMode::FrontFaceCulling;
+			if (mesh.flipsWinding && mesh.cullMode == TriangleCullMode::FrontFaceCulling) return TriangleCullMode::BackFaceCulling;
+			return mesh.cullMode;
+		}
 
-				const float t{ f * Vector3::Dot(edge2, q) };
-				if (t > ray.max || t < ray.min) continue;
+		//triangle is an index into the packed triangle data, ray is the world space ray
+		inline void FillTriangleMeshHitRecord(const TriangleMesh& mesh, const Ray& ray, float t, uint32_t triangle, HitRecord& hitRecord)
+		{
+			const TriangleSoA& triangles{ mesh.triangleData };
+			hitRecord.t = t;
+			hitRecord.origin = ray.origin + ray.direction * hitRecord.t;
+			hitRecord.didHit = true;
+			hitRecord.materialIndex = mesh.materialIndex;
+			hitRecord.normal = mesh.normalTransform.TransformVector(Vector3::Cross(triangles.GetEdge1(triangle), triangles.GetEdge2(triangle))).Normalized();
+		}
 
-				if (t < distance)
+		//Mesh triangles are intersected in object space, the direction is left unnormalized so t means the same in both spaces
+		inline Ray GetObjectSpaceRay(const TriangleMesh& mesh, const Ray& ray)
+		{
+			return { mesh.inverseWorldTransform.TransformPoint(ray.origin), mesh.inverseWorldTransform.TransformVector(ray.direction), ray.min, ray.max };
+		}
+
+		inline bool HitTest_TriangleMesh(const TriangleMesh& mesh, const Ray& ray, HitRecord& hitRecord, bool ignoreHitRecord = false)
+		{
+			////todo W5
+			const std::vector<BVHNode>& nodes{ mesh.bvh.GetNodes() };
+			const TriangleSoA& triangles{ mesh.triangleData };
+			if (nodes.empty()) return false;
+
+			const Ray objectRay{ GetObjectSpaceRay(mesh, ray) };
+			const Vector3 inverseDirection{ 1.f / objectRay.direction.x, 1.f / objectRay.direction.y, 1.f / objectRay.direction.z };
+
+			const TriangleCullMode cullMode{ GetObjectSpaceCullMode(mesh) };
+
+			bool hasHitSomething{ false };
+			float distance = FLT_MAX;
+			float maxDistance{ ray.max };
+			uint32_t closestTriangle{};
+
+			//leaves index straight into the packed triangle data, no gather through the index buffer
+			const TriangleKernels::IntersectFunction intersect{ TriangleKernels::GetIntersectFunction() };
+			TraverseBVH(nodes, objectRay, inverseDirection, maxDistance, [&](const BVHNode& node)
 				{
-					hasHitSomething = true;
-					distance = t;
-					if (!ignoreHitRecord)
+					if (intersect(triangles, node.leftFirst, node.primitiveCount, cullMode, objectRay, distance, closestTriangle))
 					{
-						hitRecord.t = t;
-						hitRecord.origin = ray.origin + ray.direction * hitRecord.t;
-						hitRecord.didHit = true;
-						hitRecord.materialIndex = mesh.materialIndex;
-						hitRecord.normal = Vector3::Cross(edge1, edge2).Normalized();
+						hasHitSomething = true;
+						maxDistance = distance;
 					}
-				}
-			}
+					return false;
+				});
+
+			if (hasHitSomething && !ignoreHitRecord) FillTriangleMeshHitRecord(mesh, ray, distance, closestTriangle, hitRecord);
 			return hasHitSomething;
 		}
 
+		/**
+		 * \brief Any-hit query for shadow rays, stops at the first leaf that blocks the ray instead of searching for the closest hit
+		 * \param occludingTriangle set to the packed triangle that blocked the ray
+		 */
+		inline bool DoesHit_TriangleMesh(const TriangleMesh& mesh, const Ray& ray, uint32_t& occludingTriangle)
+		{
+			const std::vector<BVHNode>& nodes{ mesh.bvh.GetNodes() };
+			if (nodes.empty()) return false;
+
+			const Ray objectRay{ GetObjectSpaceRay(mesh, ray) };
+			const Vector3 inverseDirection{ 1.f / objectRay.direction.x, 1.f / objectRay.direction.y, 1.f / objectRay.direction.z };
+			const TriangleCullMode cullMode{ GetObjectSpaceCullMode(mesh) };
+
+			bool didHit{ false };
+			float maxDistance{ ray.max };
+			const TriangleKernels::IntersectFunction intersect{ TriangleKernels::GetIntersectFunction() };
+			TraverseBVH(nodes, objectRay, inverseDirection, maxDistance, [&](const BVHNode& node)
+				{
+					float distance{ FLT_MAX };
+					didHit = intersect(mesh.triangleData, node.leftFirst, node.primitiveCount, cullMode, objectRay, distance, occludingTriangle);
+					return didHit;
+				});
+			return didHit;
+		}
+
 		inline bool HitTest_TriangleMesh(const TriangleMesh& mesh, const Ray& ray)
 		{
-			HitRecord temp{};
-			return HitTest_TriangleMesh(mesh, ray, temp, true);
+			uint32_t occludingTriangle{};
+			return DoesHit_TriangleMesh(mesh, ray, occludingTriangle);
+		}
+
+		//Tests a single packed triangle of the mesh, used to retry the last known occluder before walking the BVH
+		inline bool DoesHit_MeshTriangle(const TriangleMesh& mesh, const Ray& ray, uint32_t triangle)
+		{
+			const TriangleSoA& triangles{ mesh.triangleData };
+			float t{};
+			return HitTest_MeshTriangle(triangles.GetV0(triangle), triangles.GetEdge1(triangle), triangles.GetEdge2(triangle), GetObjectSpaceCullMode(mesh), GetObjectSpaceRay(mesh, ray), t);
 		}
 #pragma endregion
 	}
@@ -246,6 +413,24 @@ namespace dae
 
 			return{};
 		}
+
+		//GetRadiance with a reciprocal estimate instead of the divide, see FastMath
+		inline ColorRGB GetRadianceFast(const Light& light, const Vector3& target)
+		{
+			if (light.type != LightType::Point) return light.color * light.intensity;
+
+			const float distanceSqr{ Vector3{ light.origin - target }.SqrMagnitude() };
+			return light.color * (light.intensity * FastMath::Reciprocal(distanceSqr));
+		}
+
+		//Squared distance past which GetRadiance stays below threshold in every channel, FLT_MAX for lights that reach everywhere
+		inline float GetInfluenceRadiusSqr(const Light& light, float threshold)
+		{
+			if (light.type != LightType::Point || threshold <= 0.f) return FLT_MAX;
+
+			const float maxChannel{ std::max(light.color.r, std::max(light.color.g, light.color.b)) };
+			return light.intensity * maxChannel / threshold;
+		}
 	}
 
 	namespace Utils
@@ -304,13 +489,13 @@ namespace dae
 				Vector3 edgeV0V2 = positions[i2] - positions[i0];
 				Vector3 normal = Vector3::Cross(edgeV0V1, edgeV0V2);
 
-				if(isnan(normal.x))
+				if(std::isnan(normal.x))
 				{
 					int k = 0;
 				}
 
 				normal.Normalize();
-				if (isnan(normal.x))
+				if (std::isnan(normal.x))
 				{
 					int k = 0;
 				}
@@ -1,9 +1,23 @@
 #pragma once
+#include <cassert>
+#include <cmath>
+#include <type_traits>
+
+#include "Vector3.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define MATH_SIMD_SSE
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#define MATH_SIMD_NEON
+#include <arm_neon.h>
+#endif
 
 namespace dae
 {
-	struct Vector3;
-	struct Vector4
+	//Four floats in one 16 byte aligned register-sized block, the rows of a Matrix load straight into SSE/NEON registers.
+	//The wide paths add and multiply lane by lane in the same order as the scalar code, so both give the same bits
+	struct alignas(16) Vector4
 	{
 		float x;
 		float y;
@@ -11,22 +25,159 @@ namespace dae
 		float w;
 
 		Vector4() = default;
-		Vector4(float _x, float _y, float _z, float _w);
-		Vector4(const Vector3& v, float _w);
+		constexpr Vector4(float _x, float _y, float _z, float _w);
+		constexpr Vector4(const Vector3& v, float _w);
 
 		float Magnitude() const;
-		float SqrMagnitude() const;
+		constexpr float SqrMagnitude() const;
 		float Normalize();
 		Vector4 Normalized() const;
 
-		static float Dot(const Vector4& v1, const Vector4& v2);
+		static constexpr float Dot(const Vector4& v1, const Vector4& v2);
 
 		// operator overloading
-		Vector4 operator*(float scale) const;
-		Vector4 operator+(const Vector4& v) const;
-		Vector4 operator-(const Vector4& v) const;
-		Vector4& operator+=(const Vector4& v);
-		float& operator[](int index);
-		float operator[](int index) const;
+		constexpr Vector4 operator*(float scale) const;
+		constexpr Vector4 operator+(const Vector4& v) const;
+		constexpr Vector4 operator-(const Vector4& v) const;
+		constexpr Vector4& operator+=(const Vector4& v);
+		constexpr float& operator[](int index);
+		constexpr float operator[](int index) const;
 	};
+
+	constexpr Vector4::Vector4(float _x, float _y, float _z, float _w) : x(_x), y(_y), z(_z), w(_w) {}
+	constexpr Vector4::Vector4(const Vector3& v, float _w) : x(v.x), y(v.y), z(v.z), w(_w) {}
+
+	inline float Vector4::Magnitude() const
+	{
+		return sqrtf(x * x + y * y + z * z + w * w);
+	}
+
+	constexpr float Vector4::SqrMagnitude() const
+	{
+		return x * x + y * y + z * z + w * w;
+	}
+
+	inline float Vector4::Normalize()
+	{
+		const float m = Magnitude();
+		x /= m;
+		y /= m;
+		z /= m;
+		w /= m;
+
+		return m;
+	}
+
+	inline Vector4 Vector4::Normalized() const
+	{
+		const float m = Magnitude();
+		return { x / m, y / m, z / m, w / m };
+	}
+
+	constexpr float Vector4::Dot(const Vector4& v1, const Vector4& v2)
+	{
+		return {v1.x * v2.x + v1.y * v2.y + v1.z * v2.z + v1.w * v2.w};
+	}
+
+#pragma region Operator Overloads
+	constexpr Vector4 Vector4::operator*(float scale) const
+	{
+#if defined(MATH_SIMD_SSE)
+		if (!std::is_constant_evaluated())
+		{
+			Vector4 result;
+			_mm_store_ps(&result.x, _mm_mul_ps(_mm_load_ps(&x), _mm_set1_ps(scale)));
+			return result;
+		}
+#elif defined(MATH_SIMD_NEON)
+		if (!std::is_constant_evaluated())
+		{
+			Vector4 result;
+			vst1q_f32(&result.x, vmulq_n_f32(vld1q_f32(&x), scale));
+			return result;
+		}
+#endif
+		return { x * scale, y * scale, z * scale, w * scale };
+	}
+
+	constexpr Vector4 Vector4::operator+(const Vector4& v) const
+	{
+#if defined(MATH_SIMD_SSE)
+		if (!std::is_constant_evaluated())
+		{
+			Vector4 result;
+			_mm_store_ps(&result.x, _mm_add_ps(_mm_load_ps(&x), _mm_load_ps(&v.x)));
+			return result;
+		}
+#elif defined(MATH_SIMD_NEON)
+		if (!std::is_constant_evaluated())
+		{
+			Vector4 result;
+			vst1q_f32(&result.x, vaddq_f32(vld1q_f32(&x), vld1q_f32(&v.x)));
+			return result;
+		}
+#endif
+		return { x + v.x, y + v.y, z + v.z, w + v.w };
+	}
+
+	constexpr Vector4 Vector4::operator-(const Vector4& v) const
+	{
+#if defined(MATH_SIMD_SSE)
+		if (!std::is_constant_evaluated())
+		{
+			Vector4 result;
+			_mm_store_ps(&result.x, _mm_sub_ps(_mm_load_ps(&x), _mm_load_ps(&v.x)));
+			return result;
+		}
+#elif defined(MATH_SIMD_NEON)
+		if (!std::is_constant_evaluated())
+		{
+			Vector4 result;
+			vst1q_f32(&result.x, vsubq_f32(vld1q_f32(&x), vld1q_f32(&v.x)));
+			return result;
+		}
+#endif
+		return { x - v.x, y - v.y, z - v.z, w - v.w };
+	}
+
+	constexpr Vector4& Vector4::operator+=(const Vector4& v)
+	{
+		*this = *this + v;
+		return *this;
+	}
+
+	constexpr float& Vector4::operator[](int index)
+	{
+		assert(index <= 3 && index >= 0);
+
+		if (index == 0)return x;
+		if (index == 1)return y;
+		if (index == 2)return z;
+		return w;
+	}
+
+	constexpr float Vector4::operator[](int index) const
+	{
+		assert(index <= 3 && index >= 0);
+
+		if (index == 0)return x;
+		if (index == 1)return y;
+		if (index == 2)return z;
+		return w;
+	}
+#pragma endregion
+
+#pragma region Vector3 CONVERSIONS
+	constexpr Vector3::Vector3(const Vector4& v) : x(v.x), y(v.y), z(v.z){}
+
+	constexpr Vector4 Vector3::ToPoint4() const
+	{
+		return { x, y, z, 1 };
+	}
+
+	constexpr Vector4 Vector3::ToVector4() const
+	{
+		return { x, y, z, 0 };
+	}
+#pragma endregion
 }
@@ -0,0 +1,152 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "DataTypes.h"
+#include "LightTree.h"
+
+namespace dae
+{
+	//Structure of arrays queues the wavefront renderer hands from stage to stage, see Renderer::RenderTileWavefront.
+	//Clear keeps the capacity, so a thread reuses its queues from tile to tile without allocating
+
+	//Primary rays of the pixels that want a sample, in ray packet lane order so every 16 of them are neighbours
+	struct CameraRayQueue
+	{
+		std::vector<uint32_t> pixelIndices{};
+		std::vector<float> directionX{};
+		std::vector<float> directionY{};
+		std::vector<float> directionZ{};
+
+		uint32_t GetSize() const { return static_cast<uint32_t>(pixelIndices.size()); }
+		Vector3 GetDirection(uint32_t i) const { return { directionX[i], directionY[i], directionZ[i] }; }
+
+		void Clear()
+		{
+			pixelIndices.clear();
+			directionX.clear();
+			directionY.clear();
+			directionZ.clear();
+		}
+
+		void Push(uint32_t pixelIndex, const Vector3& direction)
+		{
+			pixelIndices.push_back(pixelIndex);
+			directionX.push_back(direction.x);
+			directionY.push_back(direction.y);
+			directionZ.push_back(direction.z);
+		}
+	};
+
+	//Camera rays that hit something, misses are finished by the closest-hit stage already
+	struct HitQueue
+	{
+		std::vector<uint32_t> pixelIndices{};
+		std::vector<float> positionX{};
+		std::vector<float> positionY{};
+		std::vector<float> positionZ{};
+		std::vector<float> normalX{};
+		std::vector<float> normalY{};
+		std::vector<float> normalZ{};
+		std::vector<float> viewDirectionX{}; //direction of the camera ray
+		std::vector<float> viewDirectionY{};
+		std::vector<float> viewDirectionZ{};
+		std::vector<float> distances{};
+		std::vector<unsigned char> materialIndices{};
+
+		uint32_t GetSize() const { return static_cast<uint32_t>(pixelIndices.size()); }
+		Vector3 GetPosition(uint32_t i) const { return { positionX[i], positionY[i], positionZ[i] }; }
+		Vector3 GetViewDirection(uint32_t i) const { return { viewDirectionX[i], viewDirectionY[i], viewDirectionZ[i] }; }
+
+		HitRecord GetHitRecord(uint32_t i) const
+		{
+			return HitRecord{ GetPosition(i), { normalX[i], normalY[i], normalZ[i] }, distances[i], true, materialIndices[i] };
+		}
+
+		void Clear()
+		{
+			pixelIndices.clear();
+			positionX.clear();
+			positionY.clear();
+			positionZ.clear();
+			normalX.clear();
+			normalY.clear();
+			normalZ.clear();
+			viewDirectionX.clear();
+			viewDirectionY.clear();
+			viewDirectionZ.clear();
+			distances.clear();
+			materialIndices.clear();
+		}
+
+		void Push(uint32_t pixelIndex, const HitRecord& hit, const Vector3& viewDirection)
+		{
+			pixelIndices.push_back(pixelIndex);
+			positionX.push_back(hit.origin.x);
+			positionY.push_back(hit.origin.y);
+			positionZ.push_back(hit.origin.z);
+			normalX.push_back(hit.normal.x);
+			normalY.push_back(hit.normal.y);
+			normalZ.push_back(hit.normal.z);
+			viewDirectionX.push_back(viewDirection.x);
+			viewDirectionY.push_back(viewDirection.y);
+			viewDirectionZ.push_back(viewDirection.z);
+			distances.push_back(hit.t);
+			materialIndices.push_back(hit.materialIndex);
+		}
+	};
+
+	//A few shadow rays per hit, slot by slot: ray s of hit h is entry s * hitCount + h. Without light sampling slot s
+	//is the tile's s-th light, so all rays of a slot share the light's origin, which keeps the occluder cache of that light warm
+	struct ShadowRayQueue
+	{
+		//entries in the order they are traced, still slot by slot. Binning sorts the rays of a slot by direction octant
+		//and Morton code of the hit, so consecutive rays walk the same BVH nodes
+		std::vector<uint32_t> order{};
+		std::vector<float> directionX{};
+		std::vector<float> directionY{};
+		std::vector<float> directionZ{};
+		std::vector<float> maxDistances{};
+		std::vector<uint32_t> lightIndices{}; //LightTree::InvalidLight when no light can reach the hit or the slot's is out of range
+		std::vector<float> weights{}; //the light's contribution is scaled by this, 1 unless lights are sampled
+		std::vector<uint8_t> isVisible{}; //filled in by the any-hit stage
+		uint32_t hitCount{};
+		uint32_t slotCount{};
+
+		Vector3 GetDirection(uint32_t i) const { return { directionX[i], directionY[i], directionZ[i] }; }
+
+		void Resize(uint32_t newHitCount, uint32_t newSlotCount)
+		{
+			hitCount = newHitCount;
+			slotCount = newSlotCount;
+			const uint32_t size{ hitCount * slotCount };
+			directionX.resize(size);
+			directionY.resize(size);
+			directionZ.resize(size);
+			maxDistances.resize(size);
+			lightIndices.resize(size);
+			weights.resize(size);
+			isVisible.resize(size);
+			order.resize(size);
+		}
+	};
+
+	struct WavefrontQueues
+	{
+		CameraRayQueue cameraRays{};
+		HitQueue hits{};
+		ShadowRayQueue shadowRays{};
+		//hit indices grouped by material, the shading stage calls one material's Shade for all its hits in a row
+		std::vector<uint32_t> shadingOrder{};
+		//Morton cell of every hit and bin of every shadow ray of the slot being binned
+		std::vector<uint16_t> hitCells{};
+		std::vector<uint16_t> rayBins{};
+		//lights that reach the tile's hits, one slot each when lights are not sampled
+		std::vector<uint32_t> tileLights{};
+		//scratch of GroupShadowRaysByLight
+		std::vector<uint32_t> lightStarts{};
+		std::vector<uint32_t> groupedOrder{};
+		//one per light, for the tile being traced
+		std::vector<Occluder> occluders{};
+	};
+}
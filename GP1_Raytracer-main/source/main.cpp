@@ -1,19 +1,327 @@
 //External includes
+#if defined(_MSC_VER)
 #include "vld.h"
+#endif
 #include "SDL.h"
 #include "SDL_surface.h"
 #undef main
 
 //Standard includes
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <string>
 
 //Project includes
 #include "Timer.h"
+#include "FramePipeline.h"
 #include "Renderer.h"
+#include "ResolutionController.h"
 #include "Scene.h"
+#include "TriangleKernels.h"
 
 using namespace dae;
 
+struct Options
+{
+	std::string sceneName{ "reference" };
+	uint32_t width{ 640 };
+	uint32_t height{ 480 };
+	uint32_t frameCount{ 1 };
+	std::string outputPath{ "RayTracing_Buffer.bmp" };
+	uint32_t threadCount{}; //0 = every hardware thread
+	uint32_t tileSize{};	//0 = renderer default
+	float frameRate{ 30.f }; //animation speed of offline frames
+	uint32_t sampleCount{ 1 }; //max samples per pixel of an offline frame
+	float threshold{ 1.f / 512.f }; //standard error at which a pixel stops taking samples
+	uint32_t edgeSampleCount{}; //extra rays per edge pixel, 0 = no edge anti-aliasing
+	float edgeThreshold{ .1f };
+	uint32_t lightSampleCount{ 4 }; //shadow rays per hit in scenes with more lights, 0 = one per light
+	float lightCutoff{ 1.f / 1024.f }; //radiance below which a traced point light is skipped, 0 = never
+	float targetFrameRate{ 30.f }; //window frame rate held while the camera moves, 0 = always full resolution
+	bool isHeadless{ false };
+	bool isWavefront{ false }; //render through the staged ray queues instead of one pixel at a time
+	bool isBinningRays{ false }; //sort the wavefront's shadow rays into coherent bins before tracing them
+	bool isBenchmarkingShading{ false }; //time every lighting mode with and without shadows before rendering
+	bool isFastMath{ false }; //approximate sqrt, divides and pow while shading
+	bool isCheckingFastMath{ false }; //compare fast-math frames of the reference scenes with exact ones instead of rendering
+	float exposure{}; //in stops
+	Tonemapper::Curve tonemapCurve{ Tonemapper::Curve::Clamp };
+	bool isSRGB{ false };
+	uint32_t presentLatency{ 1 }; //window frames between rendering and presenting, 1 presents a frame while the next renders
+};
+
+void PrintUsage()
+{
+	std::cout << "Usage: RayTracer [--headless] [--wavefront] [--bin-rays] [--scene reference|bunny|test|w1|w2|w3] [--width N] [--height N]\n"
+		"                 [--frames N] [--output file.bmp|file.ppm] [--threads N] [--tile N] [--fps N]\n"
+		"                 [--samples N] [--threshold N] [--edge-samples N] [--edge-threshold N] [--target-fps N]\n"
+		"                 [--light-samples N] [--light-cutoff N] [--bench-shading] [--fast-math] [--check-fast-math]\n"
+		"                 [--exposure N] [--tonemap clamp|reinhard|aces] [--srgb] [--present-latency 0|1]\n"
+		"Without --headless the scene opens in a window, --frames, --output and --samples only apply to headless renders.\n"
+		"Offline frames take up to --samples jittered samples per pixel, a pixel stops early once the standard error\n"
+		"of its luminance drops below --threshold (0 disables that).\n"
+		"--edge-samples N gives pixels on material, depth or luminance edges N extra rays, F10 toggles it in the window.\n"
+		"While the camera moves, the window lowers its render resolution to hold --target-fps (default 30, 0 disables).\n"
+		"--wavefront renders through queues of camera, shadow and shading work, F1 toggles it in the window.\n"
+		"--bin-rays sorts its shadow rays by direction and hit position before tracing them, B toggles it in the window.\n"
+		"Scenes with more than --light-samples lights (default 4, 0 traces every light) shade each hit with that many\n"
+		"lights picked from a light tree by their likely contribution, the average over samples matches all lights.\n"
+		"When every light is traced, a point light is skipped where its radiance drops below --light-cutoff (default 1/1024).\n"
+		"--bench-shading times every lighting mode with and without shadows before a headless render, V does it in the window.\n"
+		"--fast-math shades with approximate square roots, reciprocals and pow, M toggles it in the window.\n"
+		"--check-fast-math renders the reference, bunny and test scenes with and without it and fails when the images differ\n"
+		"by more than " << Renderer::FastMathError::MaxChannelError << " levels in a channel or " << Renderer::FastMathError::MaxMeanChannelError << " levels on average.\n"
+		"Frames are rendered as linear radiance, scaled by --exposure stops (Page Up/Down in the window), tonemapped with\n"
+		"--tonemap (T cycles it) and written linearly or, with --srgb (G toggles it), sRGB encoded. --output file.pfm\n"
+		"writes the radiance itself as floats.\n"
+		"The window presents each frame while the next one renders, --present-latency 0 renders and presents in turn.\n";
+}
+
+bool ParseOptions(int argc, char* args[], Options& options)
+{
+	for (int i{ 1 }; i < argc; ++i)
+	{
+		const char* pArg{ args[i] };
+		if (std::strcmp(pArg, "--headless") == 0)
+		{
+			options.isHeadless = true;
+			continue;
+		}
+		if (std::strcmp(pArg, "--wavefront") == 0)
+		{
+			options.isWavefront = true;
+			continue;
+		}
+		if (std::strcmp(pArg, "--bin-rays") == 0)
+		{
+			options.isBinningRays = true;
+			continue;
+		}
+		if (std::strcmp(pArg, "--bench-shading") == 0)
+		{
+			options.isBenchmarkingShading = true;
+			continue;
+		}
+		if (std::strcmp(pArg, "--fast-math") == 0)
+		{
+			options.isFastMath = true;
+			continue;
+		}
+		if (std::strcmp(pArg, "--check-fast-math") == 0)
+		{
+			options.isCheckingFastMath = true;
+			continue;
+		}
+		if (std::strcmp(pArg, "--srgb") == 0)
+		{
+			options.isSRGB = true;
+			continue;
+		}
+		if (std::strcmp(pArg, "--help") == 0 || std::strcmp(pArg, "-h") == 0)
+			return false;
+
+		//every other option takes a value
+		if (pArg[0] != '-' || i + 1 >= argc)
+		{
+			std::cout << "Expected an option followed by a value at " << pArg << '\n';
+			return false;
+		}
+		const char* pValue{ args[++i] };
+		const uint32_t number{ uint32_t(std::strtoul(pValue, nullptr, 10)) };
+
+		if (std::strcmp(pArg, "--scene") == 0) options.sceneName = pValue;
+		else if (std::strcmp(pArg, "--width") == 0) options.width = number;
+		else if (std::strcmp(pArg, "--height") == 0) options.height = number;
+		else if (std::strcmp(pArg, "--frames") == 0) options.frameCount = number;
+		else if (std::strcmp(pArg, "--output") == 0) options.outputPath = pValue;
+		else if (std::strcmp(pArg, "--threads") == 0) options.threadCount = number;
+		else if (std::strcmp(pArg, "--tile") == 0) options.tileSize = number;
+		else if (std::strcmp(pArg, "--fps") == 0) options.frameRate = float(std::atof(pValue));
+		else if (std::strcmp(pArg, "--samples") == 0) options.sampleCount = number;
+		else if (std::strcmp(pArg, "--threshold") == 0) options.threshold = float(std::atof(pValue));
+		else if (std::strcmp(pArg, "--edge-samples") == 0) options.edgeSampleCount = number;
+		else if (std::strcmp(pArg, "--edge-threshold") == 0) options.edgeThreshold = float(std::atof(pValue));
+		else if (std::strcmp(pArg, "--light-samples") == 0) options.lightSampleCount = number;
+		else if (std::strcmp(pArg, "--light-cutoff") == 0) options.lightCutoff = float(std::atof(pValue));
+		else if (std::strcmp(pArg, "--target-fps") == 0) options.targetFrameRate = float(std::atof(pValue));
+		else if (std::strcmp(pArg, "--present-latency") == 0) options.presentLatency = number;
+		else if (std::strcmp(pArg, "--exposure") == 0) options.exposure = float(std::atof(pValue));
+		else if (std::strcmp(pArg, "--tonemap") == 0)
+		{
+			if (std::strcmp(pValue, "clamp") == 0) options.tonemapCurve = Tonemapper::Curve::Clamp;
+			else if (std::strcmp(pValue, "reinhard") == 0) options.tonemapCurve = Tonemapper::Curve::Reinhard;
+			else if (std::strcmp(pValue, "aces") == 0) options.tonemapCurve = Tonemapper::Curve::ACES;
+			else
+			{
+				std::cout << "Unknown tonemapping curve " << pValue << '\n';
+				return false;
+			}
+		}
+		else
+		{
+			std::cout << "Unknown option " << pArg << '\n';
+			return false;
+		}
+	}
+
+	if (options.width == 0 || options.height == 0 || options.frameCount == 0 || options.frameRate <= 0.f || options.sampleCount == 0)
+	{
+		std::cout << "Resolution, frame count, fps and sample count have to be positive\n";
+		return false;
+	}
+	return true;
+}
+
+Scene* CreateScene(const std::string& name)
+{
+	if (name == "reference") return new Scene_W4_ReferenceScene();
+	if (name == "bunny") return new Scene_W4_BunnyScene();
+	if (name == "test") return new Scene_W4_TestScene();
+	if (name == "w1") return new Scene_W1();
+	if (name == "w2") return new Scene_W2();
+	if (name == "w3") return new Scene_W3();
+	return nullptr;
+}
+
+Renderer* CreateRenderer(const Options& options)
+{
+	const auto pRenderer = new Renderer(options.width, options.height);
+	if (options.threadCount != 0) pRenderer->SetThreadCount(options.threadCount);
+	if (options.tileSize != 0) pRenderer->SetTileSize(options.tileSize);
+	pRenderer->SetConvergenceThreshold(options.threshold);
+	pRenderer->SetEdgeThreshold(options.edgeThreshold);
+	if (options.edgeSampleCount > 0) pRenderer->SetEdgeSampleCount(options.edgeSampleCount);
+	pRenderer->SetLightSampleCount(options.lightSampleCount);
+	pRenderer->SetLightCutoff(options.lightCutoff);
+	if (options.isHeadless) pRenderer->SetMaxSamples(options.sampleCount);
+	if (options.isWavefront) pRenderer->ToggleWavefront();
+	if (options.isBinningRays) pRenderer->ToggleRayBinning();
+	if (options.isFastMath) pRenderer->ToggleFastMath();
+	if (options.exposure != 0.f) pRenderer->SetExposure(options.exposure);
+	pRenderer->SetTonemapCurve(options.tonemapCurve);
+	pRenderer->SetSRGB(options.isSRGB);
+	return pRenderer;
+}
+
+//Renders the first frame of every reference scene exactly and with fast math, returns 1 when any of them is further
+//apart than Renderer::FastMathError allows
+int CheckFastMath(const Options& options)
+{
+	int result{};
+	for (const char* pSceneName : { "reference", "bunny", "test" })
+	{
+		Scene* pScene{ CreateScene(pSceneName) };
+		pScene->Initialize();
+		pScene->UpdateTopLevelBVH();
+		Renderer* pRenderer{ CreateRenderer(options) };
+
+		const Renderer::FastMathError error{ pRenderer->CompareFastMath(pScene) };
+		const bool isWithinBounds{ error.IsWithinBounds() };
+		if (!isWithinBounds) result = 1;
+
+		std::cout << (isWithinBounds ? "PASS " : "FAIL ") << pSceneName << ": " << error.differingPixelCount << " pixels differ, max "
+			<< error.maxChannelError << " levels, mean " << error.meanChannelError << " levels. Exact " << error.exactMs << " ms, fast "
+			<< error.fastMs << " ms" << std::endl;
+
+		delete pScene;
+		delete pRenderer;
+	}
+	return result;
+}
+
+//The keys and mouse buttons that move the camera, SDL's state this frame
+CameraInput ReadCameraInput()
+{
+	const uint8_t* pKeyboardState{ SDL_GetKeyboardState(nullptr) };
+	CameraInput input{};
+	input.isMovingForward = pKeyboardState[SDL_SCANCODE_W];
+	input.isMovingBackward = pKeyboardState[SDL_SCANCODE_S];
+	input.isMovingLeft = pKeyboardState[SDL_SCANCODE_A];
+	input.isMovingRight = pKeyboardState[SDL_SCANCODE_D];
+	input.isMovingUp = pKeyboardState[SDL_SCANCODE_Q];
+	input.isMovingDown = pKeyboardState[SDL_SCANCODE_E];
+	input.isWideningFov = pKeyboardState[SDL_SCANCODE_DOWN];
+	input.isNarrowingFov = pKeyboardState[SDL_SCANCODE_UP];
+
+	const uint32_t mouseState{ SDL_GetRelativeMouseState(&input.mouseX, &input.mouseY) };
+	input.isLeftButtonDown = mouseState & SDL_BUTTON_LMASK;
+	input.isRightButtonDown = mouseState & SDL_BUTTON_RMASK;
+	return input;
+}
+
+//"out.bmp" -> "out_0003.bmp", so an animation does not overwrite its own frames
+std::string GetFramePath(const std::string& path, uint32_t frame)
+{
+	char number[16]{};
+	std::snprintf(number, sizeof(number), "_%04u", frame);
+
+	const size_t extension{ path.find_last_of('.') };
+	const size_t directory{ path.find_last_of("/\\") };
+	if (extension == std::string::npos || (directory != std::string::npos && extension < directory))
+		return path + number;
+	return path.substr(0, extension) + number + path.substr(extension);
+}
+
+//Renders straight into the renderer's framebuffer without opening a window, the frame times only contain the render itself
+int RenderHeadless(const Options& options, Scene* pScene, Renderer* pRenderer)
+{
+	Timer timer{};
+	timer.SetFixedTimeStep(1.f / options.frameRate);
+	timer.Start();
+
+	double totalMs{};
+	uint32_t totalPassCount{};
+	for (uint32_t frame{}; frame < options.frameCount; ++frame)
+	{
+		pScene->Update(&timer);
+		pScene->UpdateTopLevelBVH();
+
+		//every pass adds a sample to the pixels that have not converged yet. The renderer starts over by itself where the
+		//scene changed, pixels that moving geometry cannot reach keep last frame's samples
+		const auto start{ std::chrono::steady_clock::now() };
+		uint32_t passCount{};
+		uint32_t edgePixelCount{};
+		uint32_t reusedPixelCount{};
+		do
+		{
+			pRenderer->Render(pScene);
+			edgePixelCount += pRenderer->GetEdgePixelCount();
+			if (passCount == 0) reusedPixelCount = pRenderer->GetReusedPixelCount();
+			++passCount;
+		} while (passCount < options.sampleCount && !pRenderer->HasConverged());
+		const double frameMs{ std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() };
+		totalMs += frameMs;
+		totalPassCount += passCount;
+
+		const std::string path{ options.frameCount == 1 ? options.outputPath : GetFramePath(options.outputPath, frame + 1) };
+		if (!pRenderer->SaveBufferToImage(path))
+		{
+			std::cout << "Could not write " << path << std::endl;
+			return 1;
+		}
+		std::cout << "Frame " << frame + 1 << '/' << options.frameCount << ": " << frameMs << " ms, " << passCount << " pass(es)";
+		if (reusedPixelCount > 0)
+			std::cout << ", " << reusedPixelCount << " pixels reused";
+		if (pRenderer->GetShadowRayCount() > 0)
+			std::cout << ", " << double(pRenderer->GetShadowNodeCount()) / pRenderer->GetShadowRayCount() << " BVH nodes per shadow ray";
+		if (options.edgeSampleCount > 0)
+			std::cout << ", " << edgePixelCount << " edge pixels (" << edgePixelCount * options.edgeSampleCount << " extra rays)";
+		std::cout << " -> " << path << '\n';
+
+		//same order as the interactive loop, so the first frame shows the scene at time 0
+		timer.Update();
+	}
+
+	const double averageMs{ totalMs / options.frameCount };
+	std::cout << "Rendered " << options.frameCount << " frame(s) of " << options.width << 'x' << options.height
+		<< " on " << pRenderer->GetThreadCount() << " thread(s): avg " << averageMs << " ms, "
+		<< 1000.0 / averageMs << " fps, " << totalMs / totalPassCount << " ms per pass" << std::endl;
+	return 0;
+}
+
 void ShutDown(SDL_Window* pWindow)
 {
 	SDL_DestroyWindow(pWindow);
@@ -22,34 +330,60 @@ void ShutDown(SDL_Window* pWindow)
 
 int main(int argc, char* args[])
 {
+	Options options{};
+	if (!ParseOptions(argc, args, options))
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	if (options.isCheckingFastMath) return CheckFastMath(options);
+
+	const auto pScene = CreateScene(options.sceneName);
+	if (!pScene)
+	{
+		std::cout << "Unknown scene " << options.sceneName << '\n';
+		PrintUsage();
+		return 1;
+	}
+
+	const auto pRenderer = CreateRenderer(options);
 
-	//Unreferenced parameters
-	(void)argc;
-	(void)args;
+	pScene->Initialize();
+	pScene->UpdateTopLevelBVH();
+	pScene->PrintAccelerationStructureStats();
+
+	if (options.isHeadless)
+	{
+		if (options.isBenchmarkingShading) pRenderer->PrintShadingBenchmark(pScene);
+		const int result{ RenderHeadless(options, pScene, pRenderer) };
+		delete pScene;
+		delete pRenderer;
+		return result;
+	}
 
 	//Create window + surfaces
 	SDL_Init(SDL_INIT_VIDEO);
 
-	const uint32_t width = 640;
-	const uint32_t height = 480;
-
 	SDL_Window* pWindow = SDL_CreateWindow(
 		"RayTracer - **Vik Praet (2DAE10)**",
 		SDL_WINDOWPOS_UNDEFINED,
 		SDL_WINDOWPOS_UNDEFINED,
-		width, height, 0);
+		options.width, options.height, 0);
 
 	if (!pWindow)
+	{
+		delete pScene;
+		delete pRenderer;
+		SDL_Quit();
 		return 1;
+	}
+	SDL_Surface* pWindowSurface = SDL_GetWindowSurface(pWindow);
 
 	//Initialize "framework"
 	const auto pTimer = new Timer();
-	const auto pRenderer = new Renderer(pWindow);
-
-	const auto pScene = new Scene_W4_ReferenceScene();
-	//const auto pScene = new Scene_W4_BunnyScene();
-	//const auto pScene = new Scene_W4_TestScene();
-	pScene->Initialize();
+	ResolutionController resolutionController{ options.targetFrameRate };
+	FramePipeline framePipeline{ pRenderer, options.presentLatency };
 
 	//Start loop
 	pTimer->Start();
@@ -58,10 +392,42 @@ int main(int argc, char* args[])
 	// pTimer->StartBenchmark();
 
 	float printTimer = 0.f;
+	double presentMs{};
 	bool isLooping = true;
 	bool takeScreenshot = false;
 	while (isLooping)
 	{
+		//--------- Finish the frame in flight ---------
+		//input, the scene and the renderer are only touched once it is done. Its stats and the front buffer describe it
+		//until the next Render
+		framePipeline.Wait();
+
+		if (printTimer >= 1.f)
+		{
+			printTimer = 0.f;
+			std::cout << "dFPS: " << pTimer->GetdFPS() << " (render " << framePipeline.GetRenderMs() << " ms, present " << presentMs << " ms)";
+			if (pRenderer->GetEdgePixelCount() > 0)
+				std::cout << " (" << pRenderer->GetEdgePixelCount() << " edge pixels, " << pRenderer->GetEdgeSampleCount() << " extra rays each)";
+			if (pRenderer->GetReusedPixelCount() > 0)
+				std::cout << " (" << pRenderer->GetReusedPixelCount() * 100 / (pRenderer->GetRenderWidth() * pRenderer->GetRenderHeight()) << "% reused)";
+			if (pRenderer->GetRenderScale() < 1.f)
+				std::cout << " (rendering " << pRenderer->GetRenderWidth() << 'x' << pRenderer->GetRenderHeight() << ')';
+			std::cout << std::endl;
+		}
+
+		//Save screenshot after full render
+		if (takeScreenshot)
+		{
+			const uint32_t* pFrontBuffer{ framePipeline.GetFrontBuffer() };
+			if (pFrontBuffer && pRenderer->SaveBufferToImage(pFrontBuffer))
+				std::cout << "Screenshot saved!" << std::endl;
+			else
+				std::cout << "Something went wrong. Screenshot not saved!" << std::endl;
+			takeScreenshot = false;
+		}
+
+		pRenderer->SetRenderScale(resolutionController.Update(pTimer->GetElapsed(), pRenderer->HasCameraMoved()));
+
 		//--------- Get input events ---------
 		SDL_Event e;
 		while (SDL_PollEvent(&e))
@@ -74,12 +440,47 @@ int main(int argc, char* args[])
 			case SDL_KEYUP:
 				if(e.key.keysym.scancode == SDL_SCANCODE_X)
 					takeScreenshot = true;
+				if (e.key.keysym.scancode == SDL_SCANCODE_B)
+					pRenderer->ToggleRayBinning();
+				if (e.key.keysym.scancode == SDL_SCANCODE_V)
+					pRenderer->PrintShadingBenchmark(pScene);
+				if (e.key.keysym.scancode == SDL_SCANCODE_M)
+					pRenderer->ToggleFastMath();
+				if (e.key.keysym.scancode == SDL_SCANCODE_T)
+					pRenderer->CycleTonemapCurve();
+				if (e.key.keysym.scancode == SDL_SCANCODE_G)
+					pRenderer->ToggleSRGB();
+				if (e.key.keysym.scancode == SDL_SCANCODE_PAGEUP)
+					pRenderer->SetExposure(pRenderer->GetExposure() + .5f);
+				if (e.key.keysym.scancode == SDL_SCANCODE_PAGEDOWN)
+					pRenderer->SetExposure(pRenderer->GetExposure() - .5f);
+				if (e.key.keysym.scancode == SDL_SCANCODE_F1)
+					pRenderer->ToggleWavefront();
 				if (e.key.keysym.scancode == SDL_SCANCODE_F2)
 					pRenderer->ToggleShadows();
 				if (e.key.keysym.scancode == SDL_SCANCODE_F3)
 					pRenderer->CycleLigntingMode();
+				if (e.key.keysym.scancode == SDL_SCANCODE_F4)
+					pRenderer->TogglePacketTracing();
+				if (e.key.keysym.scancode == SDL_SCANCODE_F5)
+					pRenderer->ToggleAccumulation();
 				if (e.key.keysym.scancode == SDL_SCANCODE_F6)
 					pTimer->StartBenchmark();
+				if (e.key.keysym.scancode == SDL_SCANCODE_F7)
+					pScene->ToggleMeshDeformation();
+				if (e.key.keysym.scancode == SDL_SCANCODE_F8)
+					pScene->PrintBVHUpdateBenchmark();
+				if (e.key.keysym.scancode == SDL_SCANCODE_F10)
+					pRenderer->ToggleEdgeAntiAliasing();
+				if (e.key.keysym.scancode == SDL_SCANCODE_F11)
+					pRenderer->ToggleReprojection();
+				if (e.key.keysym.scancode == SDL_SCANCODE_F12)
+					pRenderer->ToggleDirtyRegions();
+				if (e.key.keysym.scancode == SDL_SCANCODE_F9)
+				{
+					TriangleKernels::CycleActiveKernel();
+					std::cout << "Triangle kernel: " << TriangleKernels::GetKernelName(TriangleKernels::GetActiveKernel()) << '\n';
+				}
 				break;
 			case SDL_MOUSEWHEEL:
 				float fovIncrement{ 3 };
@@ -98,30 +499,30 @@ int main(int argc, char* args[])
 		}
 
 		//--------- Update ---------
+		pScene->GetCamera().Update(pTimer->GetElapsed(), ReadCameraInput());
 		pScene->Update(pTimer);
+		pScene->UpdateTopLevelBVH();
 
 		//--------- Render ---------
-		pRenderer->Render(pScene);
+		framePipeline.Render(pScene);
 
-		//--------- Timer ---------
-		pTimer->Update();
-		printTimer += pTimer->GetElapsed();
-		if (printTimer >= 1.f)
+		//--------- Present ---------
+		//the previous frame with a latency of 1, while this one renders in the background
+		if (const uint32_t* pFrontBuffer{ framePipeline.GetFrontBuffer() })
 		{
-			printTimer = 0.f;
-			std::cout << "dFPS: " << pTimer->GetdFPS() << std::endl;
+			const auto presentStart{ std::chrono::steady_clock::now() };
+			SDL_ConvertPixels(options.width, options.height,
+				SDL_PIXELFORMAT_ARGB8888, pFrontBuffer, options.width * sizeof(uint32_t),
+				pWindowSurface->format->format, pWindowSurface->pixels, pWindowSurface->pitch);
+			SDL_UpdateWindowSurface(pWindow);
+			presentMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - presentStart).count();
 		}
 
-		//Save screenshot after full render
-		if (takeScreenshot)
-		{
-			if (!pRenderer->SaveBufferToImage())
-				std::cout << "Screenshot saved!" << std::endl;
-			else
-				std::cout << "Something went wrong. Screenshot not saved!" << std::endl;
-			takeScreenshot = false;
-		}
+		//--------- Timer ---------
+		pTimer->Update();
+		printTimer += pTimer->GetElapsed();
 	}
+	framePipeline.Wait();
 	pTimer->Stop();
 
 	//Shutdown "framework"
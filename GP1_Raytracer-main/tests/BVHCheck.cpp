@@ -0,0 +1,297 @@
+//Standard includes
+#include <algorithm>
+#include <bit>
+#include <cfloat>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+//Project includes
+#include "Material.h"
+#include "Scene.h"
+#include "Utils.h"
+
+using namespace dae;
+
+//Checks the acceleration structures against what they replaced:
+//- closest hits through the mesh BVHs and the top level BVH against a loop over every triangle, before and after the
+//  meshes deform and are refitted
+//- every node of a refitted BVH still bounds its triangles
+//- Matrix::Inverse and the normal transform the meshes use
+namespace
+{
+	std::mt19937 g_Random{ 7 };
+
+	float Random(float min, float max)
+	{
+		return std::uniform_real_distribution<float>{ min, max }(g_Random);
+	}
+
+	Vector3 RandomVector(float min, float max)
+	{
+		return { Random(min, max), Random(min, max), Random(min, max) };
+	}
+
+	//A bumpy grid, so neighbouring triangles share edges like in a real mesh
+	void CreateGrid(uint32_t size, std::vector<Vector3>& positions, std::vector<int>& indices)
+	{
+		for (uint32_t y{}; y <= size; ++y)
+		{
+			for (uint32_t x{}; x <= size; ++x)
+				positions.push_back({ float(x) / size * 2.f - 1.f, Random(-.1f, .1f), float(y) / size * 2.f - 1.f });
+		}
+
+		const int rowLength{ int(size) + 1 };
+		for (int y{}; y < int(size); ++y)
+		{
+			for (int x{}; x < int(size); ++x)
+			{
+				const int corner{ y * rowLength + x };
+				indices.insert(indices.end(), { corner, corner + rowLength, corner + 1, corner + 1, corner + rowLength, corner + rowLength + 1 });
+			}
+		}
+	}
+
+	//Overlapping grids with their own rotation, scale and translation, one of them mirrored. Meshes are added directly,
+	//without materials or lights, the checks only trace rays
+	class CheckScene final : public Scene
+	{
+	public:
+		void Initialize() override
+		{
+			const TriangleCullMode cullModes[]{ TriangleCullMode::NoCulling, TriangleCullMode::BackFaceCulling, TriangleCullMode::FrontFaceCulling };
+			for (uint32_t i{}; i < 5; ++i)
+			{
+				TriangleMesh* pMesh{ AddTriangleMesh(cullModes[i % 3]) };
+				CreateGrid(12 + i * 5, pMesh->positions, pMesh->indices);
+				pMesh->CalculateNormals();
+				pMesh->Rotate(Random(-1.f, 1.f), Random(-3.f, 3.f), Random(-1.f, 1.f));
+				pMesh->Scale(i == 3 ? Vector3{ -1.2f, .8f, 1.5f } : Vector3{ Random(.5f, 2.f), Random(.5f, 2.f), Random(.5f, 2.f) });
+				pMesh->Translate(RandomVector(-1.5f, 1.5f));
+				pMesh->UpdateTransforms();
+			}
+		}
+
+		//Moves every vertex a little, refitting the mesh BVHs (or rebuilding them once they degrade) like a deforming mesh
+		void Deform()
+		{
+			for (TriangleMesh& mesh : m_TriangleMeshGeometries)
+			{
+				for (Vector3& position : mesh.positions) position += RandomVector(-.15f, .15f);
+				mesh.arePositionsDirty = true;
+				mesh.UpdateTransforms();
+			}
+		}
+
+		const std::vector<TriangleMesh>& GetMeshes() const { return m_TriangleMeshGeometries; }
+	};
+
+	//What the scene did before it had BVHs: every triangle of every mesh, each tested in the mesh's object space
+	float ScanMeshes(const std::vector<TriangleMesh>& meshes, const Ray& ray)
+	{
+		float closestT{ FLT_MAX };
+		for (const TriangleMesh& mesh : meshes)
+		{
+			const Ray objectRay{ GeometryUtils::GetObjectSpaceRay(mesh, ray) };
+			const TriangleCullMode cullMode{ GeometryUtils::GetObjectSpaceCullMode(mesh) };
+			for (size_t i{}; i < mesh.indices.size(); i += 3)
+			{
+				const Vector3& v0{ mesh.positions[mesh.indices[i]] };
+				float t{};
+				if (GeometryUtils::HitTest_MeshTriangle(v0, mesh.positions[mesh.indices[i + 1]] - v0, mesh.positions[mesh.indices[i + 2]] - v0, cullMode, objectRay, t))
+					closestT = std::min(closestT, t);
+			}
+		}
+		return closestT;
+	}
+
+	//The same loop over the triangles moved to world space, the instance transforms are not involved at all
+	float ScanWorldTriangles(const std::vector<TriangleMesh>& meshes, const Ray& ray)
+	{
+		float closestT{ FLT_MAX };
+		for (const TriangleMesh& mesh : meshes)
+		{
+			for (size_t i{}; i < mesh.indices.size(); i += 3)
+			{
+				const Vector3 v0{ mesh.worldTransform.TransformPoint(mesh.positions[mesh.indices[i]]) };
+				const Vector3 v1{ mesh.worldTransform.TransformPoint(mesh.positions[mesh.indices[i + 1]]) };
+				const Vector3 v2{ mesh.worldTransform.TransformPoint(mesh.positions[mesh.indices[i + 2]]) };
+				float t{};
+				if (GeometryUtils::HitTest_MeshTriangle(v0, v1 - v0, v2 - v0, mesh.cullMode, ray, t)) closestT = std::min(closestT, t);
+			}
+		}
+		return closestT;
+	}
+
+	bool CheckClosestHits(const char* pStage, const CheckScene& scene)
+	{
+		constexpr uint32_t RayCount{ 3000 };
+		//the world space loop rounds differently, it has to agree on t this closely and on hit or miss for all but
+		//rays that graze an edge
+		constexpr float MaxRelativeError{ 1e-4f };
+		constexpr uint32_t MaxGrazingRays{ RayCount / 500 };
+
+		uint32_t hitCount{}, scanMismatchCount{}, worldMismatchCount{}, grazingCount{};
+		for (uint32_t rayIndex{}; rayIndex < RayCount; ++rayIndex)
+		{
+			Ray ray{};
+			ray.origin = RandomVector(-6.f, 6.f);
+			ray.direction = (RandomVector(-1.f, 1.f) - ray.origin).Normalized();
+			if (rayIndex % 5 == 0) ray.max = Random(1.f, 8.f);
+
+			HitRecord hit{};
+			scene.GetClosestHit(ray, hit);
+			if (hit.didHit) ++hitCount;
+
+			const float scanT{ ScanMeshes(scene.GetMeshes(), ray) };
+			const bool isScanHit{ scanT < FLT_MAX };
+			if (hit.didHit != isScanHit || (isScanHit && std::bit_cast<uint32_t>(hit.t) != std::bit_cast<uint32_t>(scanT)))
+			{
+				if (++scanMismatchCount <= 10)
+					std::cout << "  " << pStage << ": ray " << rayIndex << " BVH t " << (hit.didHit ? hit.t : -1.f) << ", loop t " << (isScanHit ? scanT : -1.f) << '\n';
+			}
+
+			const float worldT{ ScanWorldTriangles(scene.GetMeshes(), ray) };
+			const bool isWorldHit{ worldT < FLT_MAX };
+			if (hit.didHit != isWorldHit)
+			{
+				++grazingCount;
+			}
+			else if (isWorldHit && std::abs(hit.t - worldT) > MaxRelativeError * worldT)
+			{
+				if (++worldMismatchCount <= 10)
+					std::cout << "  " << pStage << ": ray " << rayIndex << " BVH t " << hit.t << ", world space loop t " << worldT << '\n';
+			}
+		}
+
+		const bool isPassing{ scanMismatchCount == 0 && worldMismatchCount == 0 && grazingCount <= MaxGrazingRays };
+		std::cout << (isPassing ? "PASS " : "FAIL ") << pStage << ": " << scanMismatchCount << " of " << RayCount << " closest hits (" << hitCount << " hits) differ from the loop over "
+			<< "every triangle, " << worldMismatchCount << " from the world space loop, " << grazingCount << " hit or miss only in world space" << std::endl;
+		return isPassing;
+	}
+
+	bool Contains(const BVHNode& node, const Vector3& point)
+	{
+		return point.x >= node.minAABB.x && point.y >= node.minAABB.y && point.z >= node.minAABB.z
+			&& point.x <= node.maxAABB.x && point.y <= node.maxAABB.y && point.z <= node.maxAABB.z;
+	}
+
+	//Every vertex of every triangle under a node has to lie in its box, checked for each node on the way down
+	bool CheckRefit()
+	{
+		std::vector<Vector3> positions{};
+		std::vector<int> indices{};
+		CreateGrid(40, positions, indices);
+
+		BVH bvh{};
+		bvh.Build(positions, indices);
+
+		uint32_t violationCount{};
+		for (uint32_t step{}; step < 10; ++step)
+		{
+			for (Vector3& position : positions) position += RandomVector(-.2f, .2f);
+			bvh.Refit(positions, indices);
+
+			const std::vector<BVHNode>& nodes{ bvh.GetNodes() };
+			const std::vector<uint32_t>& primitives{ bvh.GetPrimitiveIndices() };
+			std::vector<std::pair<uint32_t, std::vector<uint32_t>>> stack{ { 0, {} } };
+			while (!stack.empty())
+			{
+				auto [nodeIndex, ancestors] = stack.back();
+				stack.pop_back();
+				ancestors.push_back(nodeIndex);
+
+				const BVHNode& node{ nodes[nodeIndex] };
+				if (!node.IsLeaf())
+				{
+					stack.emplace_back(node.leftFirst, ancestors);
+					stack.emplace_back(node.leftFirst + 1, ancestors);
+					continue;
+				}
+
+				for (uint32_t i{ node.leftFirst }; i < node.leftFirst + node.primitiveCount; ++i)
+				{
+					for (uint32_t corner{}; corner < 3; ++corner)
+					{
+						const Vector3& position{ positions[indices[primitives[i] * 3 + corner]] };
+						for (uint32_t ancestor : ancestors)
+						{
+							if (!Contains(nodes[ancestor], position)) ++violationCount;
+						}
+					}
+				}
+			}
+		}
+
+		const bool isPassing{ violationCount == 0 };
+		std::cout << (isPassing ? "PASS " : "FAIL ") << "refit: " << violationCount << " vertices outside a node box after 10 refits" << std::endl;
+		return isPassing;
+	}
+
+	bool IsNear(float a, float b, float tolerance)
+	{
+		return std::abs(a - b) <= tolerance;
+	}
+
+	//M * Inverse(M) has to give the identity, and the normal transform has to keep a surface normal perpendicular to the
+	//transformed surface, also under non-uniform and mirroring scales
+	bool CheckTransforms()
+	{
+		constexpr float Tolerance{ 1e-5f };
+
+		uint32_t inverseErrorCount{}, normalErrorCount{};
+		for (uint32_t i{}; i < 1000; ++i)
+		{
+			Vector3 scale{ RandomVector(.2f, 4.f) };
+			if (i % 4 == 0) scale.x = -scale.x;
+			const Matrix transform{ Matrix::CreateRotation(Random(-3.f, 3.f), Random(-3.f, 3.f), Random(-3.f, 3.f)) * Matrix::CreateScale(scale)
+				* Matrix::CreateTranslation(RandomVector(-10.f, 10.f)) };
+
+			const Matrix inverse{ Matrix::Inverse(transform) };
+			for (const Matrix& product : { transform * inverse, inverse * transform })
+			{
+				for (int row{}; row < 4; ++row)
+				{
+					for (int column{}; column < 4; ++column)
+					{
+						if (!IsNear(product[row][column], row == column ? 1.f : 0.f, Tolerance)) ++inverseErrorCount;
+					}
+				}
+			}
+
+			const Vector3 edge1{ RandomVector(-1.f, 1.f) }, edge2{ RandomVector(-1.f, 1.f) };
+			const Vector3 normal{ Vector3::Cross(edge1, edge2) };
+			if (normal.SqrMagnitude() < .01f) continue;
+
+			const Vector3 transformedNormal{ Matrix::Transpose(inverse).TransformVector(normal).Normalized() };
+			const Vector3 worldEdge1{ transform.TransformVector(edge1).Normalized() }, worldEdge2{ transform.TransformVector(edge2).Normalized() };
+			if (!IsNear(Vector3::Dot(transformedNormal, worldEdge1), 0.f, Tolerance) || !IsNear(Vector3::Dot(transformedNormal, worldEdge2), 0.f, Tolerance))
+				++normalErrorCount;
+		}
+
+		const bool isPassing{ inverseErrorCount == 0 && normalErrorCount == 0 };
+		std::cout << (isPassing ? "PASS " : "FAIL ") << "transforms: " << inverseErrorCount << " entries of M * Inverse(M) off the identity, "
+			<< normalErrorCount << " transformed normals not perpendicular to their surface" << std::endl;
+		return isPassing;
+	}
+}
+
+int main()
+{
+	CheckScene scene{};
+	scene.Initialize();
+	scene.UpdateTopLevelBVH();
+	bool isPassing{ CheckClosestHits("built", scene) };
+
+	for (uint32_t step{}; step < 3; ++step)
+	{
+		scene.Deform();
+		scene.UpdateTopLevelBVH();
+	}
+	isPassing &= CheckClosestHits("refitted", scene);
+
+	isPassing &= CheckRefit();
+	isPassing &= CheckTransforms();
+	return isPassing ? 0 : 1;
+}
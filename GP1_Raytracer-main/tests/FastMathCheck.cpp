@@ -0,0 +1,39 @@
+//Standard includes
+#include <iostream>
+
+//Project includes
+#include "Renderer.h"
+#include "Scene.h"
+
+using namespace dae;
+
+//The same check as RayTracer --check-fast-math, without the window: renders the first frame of every reference scene
+//exactly and with fast math and fails when they are further apart than Renderer::FastMathError allows.
+//Run from source/, the scenes load their meshes from there
+int main()
+{
+	int result{};
+	Scene* pScenes[]{ new Scene_W4_ReferenceScene(), new Scene_W4_BunnyScene(), new Scene_W4_TestScene() };
+	const char* pSceneNames[]{ "reference", "bunny", "test" };
+
+	for (size_t i{}; i < std::size(pScenes); ++i)
+	{
+		Scene* pScene{ pScenes[i] };
+		pScene->Initialize();
+		pScene->UpdateTopLevelBVH();
+
+		//a quarter of the window's pixels is plenty to see the error and keeps the test quick
+		Renderer* pRenderer{ new Renderer(320, 240) };
+
+		const Renderer::FastMathError error{ pRenderer->CompareFastMath(pScene) };
+		const bool isWithinBounds{ error.IsWithinBounds() };
+		if (!isWithinBounds) result = 1;
+
+		std::cout << (isWithinBounds ? "PASS " : "FAIL ") << pSceneNames[i] << ": " << error.differingPixelCount << " pixels differ, max "
+			<< error.maxChannelError << " levels, mean " << error.meanChannelError << " levels" << std::endl;
+
+		delete pScene;
+		delete pRenderer;
+	}
+	return result;
+}
@@ -0,0 +1,329 @@
+//Standard includes
+#include <bit>
+#include <cfloat>
+#include <iostream>
+#include <random>
+#include <vector>
+
+//Project includes
+#include "Material.h"
+#include "RayPacket.h"
+#include "Scene.h"
+#include "TriangleKernels.h"
+#include "Utils.h"
+
+using namespace dae;
+
+//Checks that the fast intersection paths give exactly what the plain ones give:
+//- every triangle kernel against the scalar one, on random and degenerate triangles, including ranges that end in the
+//  padding after the last triangle, and through a whole mesh down to the hit normal
+//- Scene::GetClosestHits and GetOccludedLanes against the same rays traced one by one, with every kernel
+//Run from source/, the scenes load their meshes from there
+namespace
+{
+	using namespace TriangleKernels;
+
+	constexpr KernelType Kernels[]{ KernelType::Scalar, KernelType::SSE, KernelType::AVX2 };
+	constexpr TriangleCullMode CullModes[]{ TriangleCullMode::NoCulling, TriangleCullMode::BackFaceCulling, TriangleCullMode::FrontFaceCulling };
+
+	std::mt19937 g_Random{ 2024 };
+
+	float Random(float min, float max)
+	{
+		return std::uniform_real_distribution<float>{ min, max }(g_Random);
+	}
+
+	Vector3 RandomVector(float min, float max)
+	{
+		return { Random(min, max), Random(min, max), Random(min, max) };
+	}
+
+	bool IsSame(float a, float b)
+	{
+		return std::bit_cast<uint32_t>(a) == std::bit_cast<uint32_t>(b);
+	}
+
+	bool IsSame(const Vector3& a, const Vector3& b)
+	{
+		return IsSame(a.x, b.x) && IsSame(a.y, b.y) && IsSame(a.z, b.z);
+	}
+
+	bool IsSame(const HitRecord& a, const HitRecord& b)
+	{
+		if (a.didHit != b.didHit) return false;
+		if (!a.didHit) return true;
+		return IsSame(a.t, b.t) && IsSame(a.normal, b.normal) && IsSame(a.origin, b.origin) && a.materialIndex == b.materialIndex;
+	}
+
+	//Random triangles around the origin, every fourth one degenerate: a point, a line, two shared corners or a sliver
+	//far below float precision. A count that is no multiple of 8 leaves a partial last batch
+	void CreateTriangles(uint32_t triangleCount, std::vector<Vector3>& positions, std::vector<int>& indices)
+	{
+		for (uint32_t i{}; i < triangleCount; ++i)
+		{
+			const Vector3 v0{ RandomVector(-2.f, 2.f) };
+			Vector3 v1{ v0 + RandomVector(-1.f, 1.f) }, v2{ v0 + RandomVector(-1.f, 1.f) };
+			switch (i % 8)
+			{
+			case 1:
+				v1 = v2 = v0;
+				break;
+			case 3:
+				v2 = v0 + (v1 - v0) * .5f;
+				break;
+			case 5:
+				v2 = v1;
+				break;
+			case 7:
+				v2 = v0 + (v1 - v0) * .5f + Vector3{ 1e-9f, 0.f, 1e-9f };
+				break;
+			}
+
+			for (const Vector3& position : { v0, v1, v2 })
+			{
+				indices.push_back(int(positions.size()));
+				positions.push_back(position);
+			}
+		}
+	}
+
+	//Aimed at a random point of a random triangle most of the time so plenty of rays hit, otherwise anywhere. Some
+	//directions lie in an axis plane, which makes the inverse direction infinite
+	Ray CreateRay(const std::vector<Vector3>& positions)
+	{
+		Ray ray{};
+		ray.origin = RandomVector(-4.f, 4.f);
+
+		const uint32_t kind{ uint32_t(g_Random() % 8) };
+		if (kind < 6)
+		{
+			const size_t first{ g_Random() % (positions.size() / 3) * 3 };
+			const float u{ Random(0.f, 1.f) }, v{ Random(0.f, 1.f - u) };
+			const Vector3 target{ positions[first] + (positions[first + 1] - positions[first]) * u + (positions[first + 2] - positions[first]) * v };
+			ray.direction = (target - ray.origin).Normalized();
+		}
+		else
+		{
+			ray.direction = RandomVector(-1.f, 1.f).Normalized();
+		}
+		if (kind == 5) ray.direction.y = 0.f;
+
+		//now and then a ray that ends early or starts late
+		if (g_Random() % 4 == 0) ray.max = Random(.5f, 6.f);
+		if (g_Random() % 8 == 0) ray.min = Random(.5f, 2.f);
+		return ray;
+	}
+
+	bool CheckKernels()
+	{
+		constexpr uint32_t TriangleCount{ 61 }, RayCount{ 4000 };
+
+		std::vector<Vector3> positions{};
+		std::vector<int> indices{};
+		CreateTriangles(TriangleCount, positions, indices);
+
+		std::vector<uint32_t> order(TriangleCount);
+		for (uint32_t i{}; i < TriangleCount; ++i) order[i] = i;
+		TriangleSoA triangles{};
+		triangles.Build(positions, indices, order);
+
+		uint32_t testCount{}, mismatchCount{};
+		for (uint32_t rayIndex{}; rayIndex < RayCount; ++rayIndex)
+		{
+			const Ray ray{ CreateRay(positions) };
+
+			//the whole array, a random range, and every range ending on the last triangle whose last batch runs into the padding
+			std::vector<std::pair<uint32_t, uint32_t>> ranges{ { 0, TriangleCount } };
+			const uint32_t first{ uint32_t(g_Random() % TriangleCount) };
+			ranges.emplace_back(first, 1 + uint32_t(g_Random() % (TriangleCount - first)));
+			for (uint32_t count{ 1 }; count <= 9; ++count) ranges.emplace_back(TriangleCount - count, count);
+
+			for (TriangleCullMode cullMode : CullModes)
+			{
+				for (const auto& [rangeFirst, rangeCount] : ranges)
+				{
+					//unbounded, and bounded by a hit found earlier
+					for (const float startT : { FLT_MAX, Random(.5f, 8.f) })
+					{
+						float scalarT{ startT };
+						uint32_t scalarIndex{ UINT32_MAX };
+						SetActiveKernel(KernelType::Scalar);
+						const bool scalarHit{ GetIntersectFunction()(triangles, rangeFirst, rangeCount, cullMode, ray, scalarT, scalarIndex) };
+
+						for (KernelType kernel : Kernels)
+						{
+							if (kernel == KernelType::Scalar || !IsKernelSupported(kernel)) continue;
+
+							float t{ startT };
+							uint32_t index{ UINT32_MAX };
+							SetActiveKernel(kernel);
+							const bool hit{ GetIntersectFunction()(triangles, rangeFirst, rangeCount, cullMode, ray, t, index) };
+
+							++testCount;
+							if (hit != scalarHit || !IsSame(t, scalarT) || index != scalarIndex)
+							{
+								if (++mismatchCount <= 10)
+								{
+									std::cout << "  " << GetKernelName(kernel) << " differs on ray " << rayIndex << ", range [" << rangeFirst << ", "
+										<< rangeFirst + rangeCount << "): hit " << hit << " t " << t << " triangle " << index << ", scalar hit " << scalarHit
+										<< " t " << scalarT << " triangle " << scalarIndex << '\n';
+								}
+							}
+						}
+					}
+				}
+			}
+		}
+
+		const bool isPassing{ mismatchCount == 0 };
+		std::cout << (isPassing ? "PASS " : "FAIL ") << "kernels: " << mismatchCount << " of " << testCount << " tests differ from the scalar kernel" << std::endl;
+		return isPassing;
+	}
+
+	//The same triangles as a transformed mesh, so hits also go through the BVH and FillTriangleMeshHitRecord
+	bool CheckMeshHits()
+	{
+		constexpr uint32_t TriangleCount{ 203 }, RayCount{ 4000 };
+
+		std::vector<Vector3> positions{};
+		std::vector<int> indices{};
+		CreateTriangles(TriangleCount, positions, indices);
+
+		uint32_t testCount{}, mismatchCount{};
+		for (TriangleCullMode cullMode : CullModes)
+		{
+			TriangleMesh mesh{ positions, indices, cullMode };
+			mesh.materialIndex = 3;
+			mesh.Rotate(.3f, 1.1f, -.4f);
+			mesh.Scale({ 1.5f, .75f, 1.f });
+			mesh.Translate({ .5f, -.25f, 1.f });
+			mesh.UpdateTransforms();
+
+			std::vector<Vector3> worldPositions{};
+			for (const Vector3& position : positions) worldPositions.push_back(mesh.worldTransform.TransformPoint(position));
+
+			for (uint32_t rayIndex{}; rayIndex < RayCount; ++rayIndex)
+			{
+				const Ray ray{ CreateRay(worldPositions) };
+
+				HitRecord scalarHit{};
+				SetActiveKernel(KernelType::Scalar);
+				GeometryUtils::HitTest_TriangleMesh(mesh, ray, scalarHit);
+
+				for (KernelType kernel : Kernels)
+				{
+					if (kernel == KernelType::Scalar || !IsKernelSupported(kernel)) continue;
+
+					HitRecord hit{};
+					SetActiveKernel(kernel);
+					GeometryUtils::HitTest_TriangleMesh(mesh, ray, hit);
+
+					++testCount;
+					if (!IsSame(hit, scalarHit) && ++mismatchCount <= 10)
+						std::cout << "  " << GetKernelName(kernel) << " mesh hit differs on ray " << rayIndex << '\n';
+				}
+			}
+		}
+
+		const bool isPassing{ mismatchCount == 0 };
+		std::cout << (isPassing ? "PASS " : "FAIL ") << "mesh hits: " << mismatchCount << " of " << testCount << " hit records differ from the scalar kernel" << std::endl;
+		return isPassing;
+	}
+
+	//Packets from the camera: mostly coherent ones like a 4x4 pixel tile, some scattered, partly active or sparse ones that
+	//take the lane by lane fallback
+	RayPacket CreatePacket(const Camera& camera)
+	{
+		RayPacket packet{};
+		packet.origin = camera.origin;
+
+		const Vector3 center{ (camera.forward + camera.right * Random(-.6f, .6f) + camera.up * Random(-.45f, .45f)).Normalized() };
+		const float spread{ g_Random() % 8 == 0 ? 1.f : .01f };
+		for (uint32_t lane{}; lane < RayPacket::Size; ++lane)
+		{
+			packet.SetDirection(lane, (center + RandomVector(-spread, spread)).Normalized());
+		}
+
+		const uint32_t activeKind{ uint32_t(g_Random() % 4) };
+		if (activeKind == 1) packet.activeMask = uint32_t(g_Random()) & 0xFFFF;
+		if (activeKind == 2) packet.activeMask = 1u << (g_Random() % RayPacket::Size);
+		return packet;
+	}
+
+	bool CheckPackets(const char* pSceneName, Scene* pScene)
+	{
+		constexpr uint32_t PacketCount{ 1500 };
+
+		pScene->Initialize();
+		pScene->UpdateTopLevelBVH();
+		Camera& camera{ pScene->GetCamera() };
+		camera.cameraToWorld = camera.CalculateCameraToWorld();
+
+		uint32_t laneCount{}, hitMismatchCount{}, occlusionMismatchCount{};
+		for (KernelType kernel : Kernels)
+		{
+			if (!IsKernelSupported(kernel)) continue;
+			SetActiveKernel(kernel);
+
+			for (uint32_t packetIndex{}; packetIndex < PacketCount; ++packetIndex)
+			{
+				const RayPacket packet{ CreatePacket(camera) };
+
+				HitRecord packetHits[RayPacket::Size]{};
+				pScene->GetClosestHits(packet, packetHits);
+
+				float maxDistances[RayPacket::Size]{};
+				for (float& maxDistance : maxDistances) maxDistance = Random(.1f, 30.f);
+				Occluder lastOccluder{};
+				const uint32_t occludedMask{ pScene->GetOccludedLanes(packet, maxDistances, lastOccluder) };
+
+				for (uint32_t lane{}; lane < RayPacket::Size; ++lane)
+				{
+					if (!packet.IsActive(lane)) continue;
+					++laneCount;
+
+					HitRecord hit{};
+					pScene->GetClosestHit(packet.GetRay(lane), hit);
+					if (!IsSame(hit, packetHits[lane]) && ++hitMismatchCount <= 10)
+					{
+						std::cout << "  " << pSceneName << ", " << GetKernelName(kernel) << ": packet " << packetIndex << " lane " << lane << " hit t "
+							<< packetHits[lane].t << ", single ray t " << hit.t << '\n';
+					}
+
+					Ray shadowRay{ packet.GetRay(lane) };
+					shadowRay.max = maxDistances[lane];
+					const bool isOccluded{ pScene->DoesHit(shadowRay) };
+					if (isOccluded != bool((occludedMask >> lane) & 1) && ++occlusionMismatchCount <= 10)
+					{
+						std::cout << "  " << pSceneName << ", " << GetKernelName(kernel) << ": packet " << packetIndex << " lane " << lane
+							<< " occluded " << !isOccluded << ", single ray " << isOccluded << '\n';
+					}
+				}
+			}
+		}
+
+		const bool isPassing{ hitMismatchCount == 0 && occlusionMismatchCount == 0 };
+		std::cout << (isPassing ? "PASS " : "FAIL ") << pSceneName << " packets: " << hitMismatchCount << " closest hits and " << occlusionMismatchCount
+			<< " occlusion results of " << laneCount << " lanes differ from single rays" << std::endl;
+		return isPassing;
+	}
+}
+
+int main()
+{
+	const KernelType activeKernel{ GetActiveKernel() };
+
+	bool isPassing{ CheckKernels() };
+	isPassing &= CheckMeshHits();
+
+	Scene* pScenes[]{ new Scene_W4_ReferenceScene(), new Scene_W4_BunnyScene(), new Scene_W4_TestScene() };
+	const char* pSceneNames[]{ "reference", "bunny", "test" };
+	for (size_t i{}; i < std::size(pScenes); ++i)
+	{
+		isPassing &= CheckPackets(pSceneNames[i], pScenes[i]);
+		delete pScenes[i];
+	}
+
+	SetActiveKernel(activeKernel);
+	return isPassing ? 0 : 1;
+}